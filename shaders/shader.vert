@@ -1,21 +1,37 @@
 #version 450
 #extension GL_KHR_vulkan_glsl : enable
 
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+
+layout(location = 2) in vec3 instanceOffset;
+layout(location = 3) in float instanceScale;
+layout(location = 4) in vec3 instanceColor;
+
 layout(location = 0) out vec3 fragColor;
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+// the resource table, must match max_material_count in main.cpp
+layout(set = 0, binding = 0) readonly buffer Material {
+    vec4 tint;
+} materials[128];
+
+// frame constants and per draw data come from the frame's region of the upload arena at dynamic offsets
+layout(set = 1, binding = 0) uniform FrameConstants {
+    mat4 viewProjection;
+} frame;
+
+layout(set = 1, binding = 1) readonly buffer DrawData {
+    uint materialIndex[];
+} draws;
+
+layout(push_constant) uniform DrawConstants {
+    uint drawIndex;
+} draw;
 
-vec3 colors[3] = vec3[](
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-);
+// the depth pre-pass and the color pass must compute bit identical depths
+invariant gl_Position;
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
-}
\ No newline at end of file
+    gl_Position = frame.viewProjection * vec4(inPosition * instanceScale + instanceOffset.xy, instanceOffset.z, 1.0);
+    fragColor = inColor * instanceColor * materials[draws.materialIndex[draw.drawIndex]].tint.rgb;
+}
@@ -0,0 +1,167 @@
+#include "benchmark.h"
+
+#include <json/json.h>
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+
+static const benchmark_scenario benchmark_scenarios[] = {
+	{ "triangle", 1, 1, 0, false, 1, false, 1.0f, false, false, false, 1, false, 1 },
+	{ "static-triangle", 1, 1, 0, true, 1, false, 1.0f, false, false, false, 1, false, 1 },
+	{ "instanced-1m", 1000000, 1, 0, false, 1, false, 1.0f, false, false, false, 1, false, 1 },
+	{ "instanced-16m", 16000000, 1, 0, false, 1, false, 1.0f, false, false, false, 1, false, 1 },
+	{ "draws-10k", 10000, 10000, 0, false, 1, false, 1.0f, false, false, false, 1, false, 1 },
+	{ "draws-10k-threaded", 10000, 10000, 4, false, 1, false, 1.0f, false, false, false, 1, false, 1 },
+	{ "overdraw-16", 1000000, 64, 0, false, 16, false, 1.0f, false, false, false, 1, false, 1 },
+	{ "overdraw-16-prepass", 1000000, 64, 0, false, 16, true, 1.0f, false, false, false, 1, false, 1 },
+	{ "draws-10k-culled", 10000, 10000, 0, false, 1, false, 2.0f, true, false, false, 1, false, 1 },
+	{ "overdraw-16-occlusion", 1000000, 64, 0, false, 16, false, 1.0f, false, true, false, 1, false, 1 },
+	{ "instanced-1m-gpu-cull", 1000000, 1, 0, false, 1, false, 2.0f, true, false, true, 1, false, 1 },
+	{ "draws-10k-materials", 10000, 10000, 0, false, 1, false, 1.0f, false, false, false, 64, false, 1 },
+	{ "instanced-1m-msaa4", 1000000, 1, 0, false, 1, false, 1.0f, false, false, false, 1, false, 4 },
+	{ "instanced-1m-dynamic-rendering", 1000000, 1, 0, false, 1, false, 1.0f, false, false, false, 1, true, 1 }
+};
+
+bool find_benchmark_scenario(const std::string& name, benchmark_scenario& scenario)
+{
+	for (const benchmark_scenario& candidate : benchmark_scenarios)
+	{
+		if (name == candidate.name)
+		{
+			scenario = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+void print_benchmark_scenarios()
+{
+	std::cout << "benchmark scenarios:\n";
+	for (const benchmark_scenario& scenario : benchmark_scenarios)
+	{
+		std::cout << '\t' << scenario.name << ": " << scenario.instance_count << " instances in " << scenario.draw_count << " draws";
+		if (scenario.recording_threads > 0)
+		{
+			std::cout << ", " << scenario.recording_threads << " recording threads";
+		}
+		if (scenario.static_scene)
+		{
+			std::cout << ", static scene";
+		}
+		if (scenario.layers > 1)
+		{
+			std::cout << ", " << scenario.layers << " overlapping layers";
+		}
+		if (scenario.depth_prepass)
+		{
+			std::cout << ", depth pre-pass";
+		}
+		if (scenario.camera_zoom != 1.0f)
+		{
+			std::cout << ", camera zoom " << scenario.camera_zoom;
+		}
+		if (scenario.animate_camera)
+		{
+			std::cout << ", animated camera";
+		}
+		if (scenario.occlusion_cull)
+		{
+			std::cout << ", occlusion culling";
+		}
+		if (scenario.gpu_cull)
+		{
+			std::cout << ", gpu culling";
+		}
+		if (scenario.material_count > 1)
+		{
+			std::cout << ", " << scenario.material_count << " materials";
+		}
+		if (scenario.dynamic_rendering)
+		{
+			std::cout << ", dynamic rendering";
+		}
+		if (scenario.msaa_samples > 1)
+		{
+			std::cout << ", " << scenario.msaa_samples << "x MSAA";
+		}
+		std::cout << std::endl;
+	}
+}
+
+// nearest rank on an already sorted list
+static double percentile(const std::vector<double>& sorted_values, double fraction)
+{
+	size_t rank = (size_t)std::ceil(fraction * sorted_values.size());
+	return sorted_values[std::clamp(rank, (size_t)1, sorted_values.size()) - 1];
+}
+
+bool report_benchmark_result(const benchmark_result& result, const std::string& path)
+{
+	if (result.frame_times.empty())
+	{
+		std::cout << "benchmark recorded no frames after warmup!" << std::endl;
+		return false;
+	}
+
+	std::vector<double> sorted_frame_times = result.frame_times;
+	std::sort(sorted_frame_times.begin(), sorted_frame_times.end());
+
+	double total_time = 0.0;
+	for (double frame_time : sorted_frame_times)
+	{
+		total_time += frame_time;
+	}
+
+	nlohmann::json report = {
+		{ "scenario", result.scenario },
+		{ "device", result.device_name },
+		{ "present_mode", result.present_mode },
+		{ "headless", result.headless },
+		{ "frames_in_flight", result.frames_in_flight },
+		{ "instances", result.instance_count },
+		{ "draws", result.draw_count },
+		{ "recording_threads", result.recording_threads },
+		{ "layers", result.layers },
+		{ "depth_prepass", result.depth_prepass },
+		{ "camera_zoom", result.camera_zoom },
+		{ "animate_camera", result.animate_camera },
+		{ "occlusion_cull", result.occlusion_cull },
+		{ "gpu_cull", result.gpu_cull },
+		{ "materials", result.material_count },
+		{ "dynamic_rendering", result.dynamic_rendering },
+		{ "msaa_samples", result.msaa_samples },
+		{ "warmup_frames", result.warmup_frames },
+		{ "frames", sorted_frame_times.size() },
+		{ "duration_s", total_time },
+		{ "frame_time_ms", {
+			{ "min", sorted_frame_times.front() * 1000.0 },
+			{ "median", percentile(sorted_frame_times, 0.5) * 1000.0 },
+			{ "p95", percentile(sorted_frame_times, 0.95) * 1000.0 },
+			{ "p99", percentile(sorted_frame_times, 0.99) * 1000.0 },
+			{ "max", sorted_frame_times.back() * 1000.0 },
+			{ "mean", total_time * 1000.0 / sorted_frame_times.size() }
+		} },
+		{ "fps", sorted_frame_times.size() / total_time },
+		{ "scene_triangles_per_frame", result.scene_triangles_per_frame },
+		{ "triangles_per_frame", (double)result.triangles_drawn / sorted_frame_times.size() },
+		{ "triangles_per_second", (double)result.triangles_drawn / total_time }
+	};
+
+	std::cout << report.dump() << std::endl;
+
+	if (!path.empty())
+	{
+		std::ofstream file(path);
+		if (!file.is_open())
+		{
+			std::cout << "failed to open benchmark output " << path << "!" << std::endl;
+			return false;
+		}
+		file << report.dump(4) << std::endl;
+	}
+
+	return true;
+}
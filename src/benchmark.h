@@ -0,0 +1,59 @@
+#pragma once
+
+#include "vulkancommon.h"
+
+#include <string>
+#include <vector>
+
+// a named workload, benchmark runs always use one of these so results stay comparable across commits
+struct benchmark_scenario
+{
+	const char* name;
+	u32 instance_count;
+	u32 draw_count;
+	u32 recording_threads;
+	bool static_scene;
+	u32 layers;
+	bool depth_prepass;
+	float camera_zoom;
+	bool animate_camera;
+	bool occlusion_cull;
+	bool gpu_cull;
+	u32 material_count;
+	bool dynamic_rendering;
+	u32 msaa_samples;
+};
+
+bool find_benchmark_scenario(const std::string& name, benchmark_scenario& scenario);
+void print_benchmark_scenarios();
+
+// frame times are the intervals between consecutive frames after warmup, in seconds. the options are the ones the
+// run ended up with, a device can lower the sample count or fall back from gpu culling and dynamic rendering.
+// scene triangles are what one frame submits before culling, drawn triangles what the measured frames drew
+struct benchmark_result
+{
+	std::string scenario;
+	std::string device_name;
+	std::string present_mode;
+	bool headless = false;
+	u32 frames_in_flight = 0;
+	u32 instance_count = 0;
+	u32 draw_count = 0;
+	u32 recording_threads = 0;
+	u32 layers = 1;
+	bool depth_prepass = false;
+	float camera_zoom = 1.0f;
+	bool animate_camera = false;
+	bool occlusion_cull = false;
+	bool gpu_cull = false;
+	u32 material_count = 1;
+	bool dynamic_rendering = false;
+	u32 msaa_samples = 1;
+	u64 warmup_frames = 0;
+	u64 scene_triangles_per_frame = 0;
+	u64 triangles_drawn = 0;
+	std::vector<double> frame_times;
+};
+
+// writes one json object, to stdout and to path when it is not empty
+bool report_benchmark_result(const benchmark_result& result, const std::string& path);
@@ -0,0 +1,233 @@
+#include "culling.h"
+
+#include <glm/simd/matrix.h>
+
+#include <algorithm>
+#include <cmath>
+
+void add_cull_bounds(cull_bounds& bounds, glm::vec3 center, float radius)
+{
+	if (bounds.count % 4 == 0)
+	{
+		size_t padded_count = bounds.count + 4;
+		bounds.center_x.resize(padded_count, 0.0f);
+		bounds.center_y.resize(padded_count, 0.0f);
+		bounds.center_z.resize(padded_count, 0.0f);
+		bounds.radius.resize(padded_count, 0.0f);
+	}
+
+	bounds.center_x[bounds.count] = center.x;
+	bounds.center_y[bounds.count] = center.y;
+	bounds.center_z[bounds.count] = center.z;
+	bounds.radius[bounds.count] = radius;
+	bounds.count++;
+}
+
+// gribb and hartmann, the planes are sums and differences of the rows of the matrix
+frustum extract_frustum(const glm::mat4& view_projection)
+{
+	glm::vec4 rows[4];
+	for (u32 i = 0; i < 4; i++)
+	{
+		rows[i] = { view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i] };
+	}
+
+	frustum view_frustum;
+	view_frustum.planes[0] = rows[3] + rows[0];
+	view_frustum.planes[1] = rows[3] - rows[0];
+	view_frustum.planes[2] = rows[3] + rows[1];
+	view_frustum.planes[3] = rows[3] - rows[1];
+	view_frustum.planes[4] = rows[2];
+	view_frustum.planes[5] = rows[3] - rows[2];
+
+	// normalized so plane distances can be compared against radii directly
+	for (glm::vec4& plane : view_frustum.planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+	return view_frustum;
+}
+
+void cull_frustum(const cull_bounds& bounds, const frustum& view_frustum, std::vector<u32>& visible)
+{
+	visible.clear();
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+	glm_vec4 plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+	for (u32 i = 0; i < 6; i++)
+	{
+		plane_x[i] = _mm_set1_ps(view_frustum.planes[i].x);
+		plane_y[i] = _mm_set1_ps(view_frustum.planes[i].y);
+		plane_z[i] = _mm_set1_ps(view_frustum.planes[i].z);
+		plane_w[i] = _mm_set1_ps(view_frustum.planes[i].w);
+	}
+	glm_vec4 zero = _mm_setzero_ps();
+
+	for (u32 i = 0; i < bounds.count; i += 4)
+	{
+		glm_vec4 x = _mm_loadu_ps(&bounds.center_x[i]);
+		glm_vec4 y = _mm_loadu_ps(&bounds.center_y[i]);
+		glm_vec4 z = _mm_loadu_ps(&bounds.center_z[i]);
+		glm_vec4 radius = _mm_loadu_ps(&bounds.radius[i]);
+
+		// four spheres against one plane per step, a sphere survives while its distance stays above -radius
+		glm_vec4 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (u32 plane = 0; plane < 6; plane++)
+		{
+			glm_vec4 distance = glm_vec4_fma(plane_x[plane], x, glm_vec4_fma(plane_y[plane], y, glm_vec4_fma(plane_z[plane], z, plane_w[plane])));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(glm_vec4_add(distance, radius), zero));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for (u32 lane = 0; lane < 4; lane++)
+		{
+			if ((mask & (1 << lane)) && i + lane < bounds.count)
+			{
+				visible.push_back(i + lane);
+			}
+		}
+	}
+#else
+	for (u32 i = 0; i < bounds.count; i++)
+	{
+		glm::vec3 center = { bounds.center_x[i], bounds.center_y[i], bounds.center_z[i] };
+		bool inside = true;
+		for (const glm::vec4& plane : view_frustum.planes)
+		{
+			inside = inside && glm::dot(glm::vec3(plane), center) + plane.w >= -bounds.radius[i];
+		}
+		if (inside)
+		{
+			visible.push_back(i);
+		}
+	}
+#endif
+}
+
+void create_occlusion_buffer(occlusion_buffer& buffer, u32 width, u32 height)
+{
+	buffer.width = width;
+	buffer.height = height;
+	buffer.depth.assign((size_t)width * height, 1.0f);
+}
+
+void clear_occlusion_buffer(occlusion_buffer& buffer)
+{
+	std::fill(buffer.depth.begin(), buffer.depth.end(), 1.0f);
+}
+
+static glm::vec4 transform_point(const glm::mat4& view_projection, glm::vec3 point)
+{
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+	glm_vec4 columns[4] = {
+		_mm_loadu_ps(&view_projection[0][0]),
+		_mm_loadu_ps(&view_projection[1][0]),
+		_mm_loadu_ps(&view_projection[2][0]),
+		_mm_loadu_ps(&view_projection[3][0])
+	};
+	glm::vec4 result;
+	_mm_storeu_ps(&result[0], glm_mat4_mul_vec4(columns, _mm_set_ps(1.0f, point.z, point.y, point.x)));
+	return result;
+#else
+	return view_projection * glm::vec4(point, 1.0f);
+#endif
+}
+
+void rasterize_occluder(occlusion_buffer& buffer, const glm::mat4& view_projection, const glm::vec3 triangle[3])
+{
+	// triangles crossing the near or far plane would need clipping, skipping them only loses occlusion
+	glm::vec2 screen[3];
+	float farthest_depth = 0.0f;
+	for (u32 i = 0; i < 3; i++)
+	{
+		glm::vec4 clip = transform_point(view_projection, triangle[i]);
+		if (clip.w <= 1e-6f || clip.z < 0.0f || clip.z > clip.w)
+		{
+			return;
+		}
+		screen[i] = { (clip.x / clip.w * 0.5f + 0.5f) * buffer.width, (clip.y / clip.w * 0.5f + 0.5f) * buffer.height };
+		farthest_depth = std::max(farthest_depth, clip.z / clip.w);
+	}
+
+	// with y pointing down a positive area is clockwise, which is the front face of the graphics pipeline
+	float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+	if (area <= 0.0f)
+	{
+		return;
+	}
+
+	int min_x = std::max((int)std::floor(std::min({ screen[0].x, screen[1].x, screen[2].x })), 0);
+	int min_y = std::max((int)std::floor(std::min({ screen[0].y, screen[1].y, screen[2].y })), 0);
+	int max_x = std::min((int)std::ceil(std::max({ screen[0].x, screen[1].x, screen[2].x })), (int)buffer.width - 1);
+	int max_y = std::min((int)std::ceil(std::max({ screen[0].y, screen[1].y, screen[2].y })), (int)buffer.height - 1);
+
+	// edge functions a * x + b * y + c, positive inside. a texel is fully covered when its center is
+	// at least half its extent inside every edge
+	float a[3], b[3], c[3], margin[3];
+	for (u32 i = 0; i < 3; i++)
+	{
+		glm::vec2 from = screen[i];
+		glm::vec2 to = screen[(i + 1) % 3];
+		a[i] = from.y - to.y;
+		b[i] = to.x - from.x;
+		c[i] = -(a[i] * from.x + b[i] * from.y);
+		margin[i] = 0.5f * (std::abs(a[i]) + std::abs(b[i]));
+	}
+
+	for (int y = min_y; y <= max_y; y++)
+	{
+		for (int x = min_x; x <= max_x; x++)
+		{
+			float center_x = x + 0.5f;
+			float center_y = y + 0.5f;
+			bool covered = true;
+			for (u32 i = 0; i < 3; i++)
+			{
+				covered = covered && a[i] * center_x + b[i] * center_y + c[i] >= margin[i];
+			}
+			if (covered)
+			{
+				float& depth = buffer.depth[(size_t)y * buffer.width + x];
+				depth = std::min(depth, farthest_depth);
+			}
+		}
+	}
+}
+
+bool is_occluded(const occlusion_buffer& buffer, const glm::mat4& view_projection, const bounding_box& box)
+{
+	// the screen rectangle and nearest depth of the box
+	glm::vec2 screen_min = { 1e30f, 1e30f };
+	glm::vec2 screen_max = { -1e30f, -1e30f };
+	float nearest_depth = 1.0f;
+	for (u32 corner = 0; corner < 8; corner++)
+	{
+		glm::vec3 point = { corner & 1 ? box.max.x : box.min.x, corner & 2 ? box.max.y : box.min.y, corner & 4 ? box.max.z : box.min.z };
+		glm::vec4 clip = transform_point(view_projection, point);
+		if (clip.w <= 1e-6f)
+		{
+			return false;
+		}
+		glm::vec2 screen = { (clip.x / clip.w * 0.5f + 0.5f) * buffer.width, (clip.y / clip.w * 0.5f + 0.5f) * buffer.height };
+		screen_min = glm::min(screen_min, screen);
+		screen_max = glm::max(screen_max, screen);
+		nearest_depth = std::min(nearest_depth, clip.z / clip.w);
+	}
+
+	int min_x = std::max((int)std::floor(screen_min.x), 0);
+	int min_y = std::max((int)std::floor(screen_min.y), 0);
+	int max_x = std::min((int)std::ceil(screen_max.x), (int)buffer.width - 1);
+	int max_y = std::min((int)std::ceil(screen_max.y), (int)buffer.height - 1);
+
+	for (int y = min_y; y <= max_y; y++)
+	{
+		for (int x = min_x; x <= max_x; x++)
+		{
+			if (nearest_depth <= buffer.depth[(size_t)y * buffer.width + x])
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "vulkancommon.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// bounding spheres in structure of arrays layout so the frustum test handles four at a time,
+// the arrays are padded to a multiple of four so the simd loop never needs a scalar tail
+struct cull_bounds
+{
+	std::vector<float> center_x;
+	std::vector<float> center_y;
+	std::vector<float> center_z;
+	std::vector<float> radius;
+	u32 count = 0;
+};
+
+void add_cull_bounds(cull_bounds& bounds, glm::vec3 center, float radius);
+
+// planes point inwards, a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for all six
+struct frustum
+{
+	glm::vec4 planes[6];
+};
+
+// expects vulkan clip space, depth from 0 to w
+frustum extract_frustum(const glm::mat4& view_projection);
+
+// replaces visible with the indices of every sphere that touches the frustum, in ascending order
+void cull_frustum(const cull_bounds& bounds, const frustum& view_frustum, std::vector<u32>& visible);
+
+struct bounding_box
+{
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+// coarse software depth buffer for occlusion culling. occluders are rasterized conservatively, a texel only
+// takes a depth when the triangle covers all of it and then takes the triangle's farthest depth
+struct occlusion_buffer
+{
+	u32 width = 0;
+	u32 height = 0;
+	std::vector<float> depth;
+};
+
+void create_occlusion_buffer(occlusion_buffer& buffer, u32 width, u32 height);
+void clear_occlusion_buffer(occlusion_buffer& buffer);
+
+// only front faces are rasterized, matching the back face culling of the graphics pipeline
+void rasterize_occluder(occlusion_buffer& buffer, const glm::mat4& view_projection, const glm::vec3 triangle[3]);
+
+// true when the box lies entirely behind what has been rasterized so far. boxes are tighter than the culling
+// spheres in depth, which matters for flat objects stacked close together
+bool is_occluded(const occlusion_buffer& buffer, const glm::mat4& view_projection, const bounding_box& box);
@@ -0,0 +1,257 @@
+#include "descriptors.h"
+
+#include <iostream>
+
+static VkDescriptorPool create_frame_pool(descriptor_allocator& allocator)
+{
+	std::vector<VkDescriptorPoolSize> pool_sizes = allocator.pool_sizes;
+	for (VkDescriptorPoolSize& pool_size : pool_sizes)
+	{
+		pool_size.descriptorCount *= allocator.sets_per_pool;
+	}
+
+	VkDescriptorPoolCreateInfo pool_specification{};
+	pool_specification.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_specification.maxSets = allocator.sets_per_pool;
+	pool_specification.poolSizeCount = (u32)pool_sizes.size();
+	pool_specification.pPoolSizes = pool_sizes.data();
+
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	if (vkCreateDescriptorPool(allocator.device, &pool_specification, nullptr, &pool) != VK_SUCCESS)
+	{
+		std::cout << "failed to create descriptor pool!" << std::endl;
+		return VK_NULL_HANDLE;
+	}
+	return pool;
+}
+
+bool create_descriptor_allocator(VkDevice device, u32 frame_count, u32 sets_per_pool, const std::vector<VkDescriptorPoolSize>& sizes_per_set,
+	descriptor_allocator& allocator)
+{
+	allocator.device = device;
+	allocator.sets_per_pool = sets_per_pool;
+	allocator.pool_sizes = sizes_per_set;
+	allocator.frame_pools = std::vector<std::vector<VkDescriptorPool>>(frame_count);
+	allocator.current_pools = std::vector<u32>(frame_count, 0);
+
+	for (auto& pools : allocator.frame_pools)
+	{
+		VkDescriptorPool pool = create_frame_pool(allocator);
+		if (pool == VK_NULL_HANDLE)
+		{
+			return false;
+		}
+		pools.push_back(pool);
+	}
+	return true;
+}
+
+void destroy_descriptor_allocator(descriptor_allocator& allocator)
+{
+	for (auto& pools : allocator.frame_pools)
+	{
+		for (VkDescriptorPool pool : pools)
+		{
+			vkDestroyDescriptorPool(allocator.device, pool, nullptr);
+		}
+	}
+	allocator.frame_pools.clear();
+	allocator.current_pools.clear();
+}
+
+// pools a busy frame grew are kept, so the frame after it allocates without creating anything
+void reset_descriptor_frame(descriptor_allocator& allocator, u32 frame)
+{
+	for (VkDescriptorPool pool : allocator.frame_pools[frame])
+	{
+		vkResetDescriptorPool(allocator.device, pool, 0);
+	}
+	allocator.current_pools[frame] = 0;
+}
+
+VkDescriptorSet allocate_descriptor_set(descriptor_allocator& allocator, u32 frame, VkDescriptorSetLayout layout)
+{
+	std::vector<VkDescriptorPool>& pools = allocator.frame_pools[frame];
+	u32& current_pool = allocator.current_pools[frame];
+
+	VkDescriptorSetAllocateInfo allocation_specification{};
+	allocation_specification.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocation_specification.descriptorSetCount = 1;
+	allocation_specification.pSetLayouts = &layout;
+
+	while (true)
+	{
+		bool fresh_pool = false;
+		if (current_pool == pools.size())
+		{
+			VkDescriptorPool pool = create_frame_pool(allocator);
+			if (pool == VK_NULL_HANDLE)
+			{
+				return VK_NULL_HANDLE;
+			}
+			pools.push_back(pool);
+			fresh_pool = true;
+		}
+
+		allocation_specification.descriptorPool = pools[current_pool];
+		VkDescriptorSet set = VK_NULL_HANDLE;
+		VkResult result = vkAllocateDescriptorSets(allocator.device, &allocation_specification, &set);
+		if (result == VK_SUCCESS)
+		{
+			return set;
+		}
+
+		// a fresh pool failing as well means the set is larger than sizes_per_set
+		if (fresh_pool || (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL))
+		{
+			std::cout << "failed to allocate descriptor set!" << std::endl;
+			return VK_NULL_HANDLE;
+		}
+		current_pool++;
+	}
+}
+
+static void write_storage_buffer(resource_table& table, u32 slot, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	VkDescriptorBufferInfo buffer_description{};
+	buffer_description.buffer = buffer;
+	buffer_description.offset = offset;
+	buffer_description.range = range;
+
+	VkWriteDescriptorSet descriptor_write{};
+	descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptor_write.dstSet = table.set;
+	descriptor_write.dstBinding = 0;
+	descriptor_write.dstArrayElement = slot;
+	descriptor_write.descriptorCount = 1;
+	descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptor_write.pBufferInfo = &buffer_description;
+	vkUpdateDescriptorSets(table.device, 1, &descriptor_write, 0, nullptr);
+}
+
+bool create_resource_table(VkDevice device, u32 capacity, VkShaderStageFlags stages, bool update_after_bind, resource_table& table)
+{
+	table.device = device;
+	table.update_after_bind = update_after_bind;
+	table.capacity = capacity;
+	table.fallback_buffer = VK_NULL_HANDLE;
+	table.free_slots.clear();
+	table.next_slot = 0;
+
+	VkDescriptorSetLayoutBinding binding{};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	binding.descriptorCount = capacity;
+	binding.stageFlags = stages;
+
+	VkDescriptorBindingFlags binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+	VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_specification{};
+	binding_flags_specification.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	binding_flags_specification.bindingCount = 1;
+	binding_flags_specification.pBindingFlags = &binding_flags;
+
+	VkDescriptorSetLayoutCreateInfo layout_specification{};
+	layout_specification.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_specification.bindingCount = 1;
+	layout_specification.pBindings = &binding;
+	if (update_after_bind)
+	{
+		layout_specification.pNext = &binding_flags_specification;
+		layout_specification.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	}
+
+	if (vkCreateDescriptorSetLayout(device, &layout_specification, nullptr, &table.layout) != VK_SUCCESS)
+	{
+		std::cout << "failed to create resource table layout!" << std::endl;
+		return false;
+	}
+
+	VkDescriptorPoolSize pool_size{};
+	pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	pool_size.descriptorCount = capacity;
+
+	VkDescriptorPoolCreateInfo pool_specification{};
+	pool_specification.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_specification.flags = update_after_bind ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT : 0;
+	pool_specification.maxSets = 1;
+	pool_specification.poolSizeCount = 1;
+	pool_specification.pPoolSizes = &pool_size;
+
+	if (vkCreateDescriptorPool(device, &pool_specification, nullptr, &table.pool) != VK_SUCCESS)
+	{
+		std::cout << "failed to create resource table pool!" << std::endl;
+		return false;
+	}
+
+	VkDescriptorSetAllocateInfo allocation_specification{};
+	allocation_specification.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocation_specification.descriptorPool = table.pool;
+	allocation_specification.descriptorSetCount = 1;
+	allocation_specification.pSetLayouts = &table.layout;
+
+	if (vkAllocateDescriptorSets(device, &allocation_specification, &table.set) != VK_SUCCESS)
+	{
+		std::cout << "failed to allocate resource table!" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void destroy_resource_table(resource_table& table)
+{
+	vkDestroyDescriptorPool(table.device, table.pool, nullptr);
+	vkDestroyDescriptorSetLayout(table.device, table.layout, nullptr);
+	table.pool = VK_NULL_HANDLE;
+	table.layout = VK_NULL_HANDLE;
+	table.set = VK_NULL_HANDLE;
+}
+
+// partially bound descriptors may stay unwritten, so only tables without descriptor indexing fill their slots
+void set_resource_table_fallback(resource_table& table, VkBuffer fallback_buffer)
+{
+	table.fallback_buffer = fallback_buffer;
+	if (table.update_after_bind)
+	{
+		return;
+	}
+
+	for (u32 slot = table.next_slot; slot < table.capacity; slot++)
+	{
+		write_storage_buffer(table, slot, fallback_buffer, 0, VK_WHOLE_SIZE);
+	}
+	for (u32 slot : table.free_slots)
+	{
+		write_storage_buffer(table, slot, fallback_buffer, 0, VK_WHOLE_SIZE);
+	}
+}
+
+u32 register_storage_buffer(resource_table& table, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	u32 slot;
+	if (!table.free_slots.empty())
+	{
+		slot = table.free_slots.back();
+		table.free_slots.pop_back();
+	}
+	else if (table.next_slot < table.capacity)
+	{
+		slot = table.next_slot++;
+	}
+	else
+	{
+		return nullval;
+	}
+
+	write_storage_buffer(table, slot, buffer, offset, range);
+	return slot;
+}
+
+void release_storage_buffer(resource_table& table, u32 slot)
+{
+	if (!table.update_after_bind)
+	{
+		write_storage_buffer(table, slot, table.fallback_buffer, 0, VK_WHOLE_SIZE);
+	}
+	table.free_slots.push_back(slot);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "vulkancommon.h"
+
+#include <vector>
+
+// descriptor sets that only live for one frame come from that frame's pools. the pools are reset wholesale once
+// the frame has retired on the gpu instead of freeing sets one by one, and a frame that runs out grows another pool
+struct descriptor_allocator
+{
+	VkDevice device = VK_NULL_HANDLE;
+	u32 sets_per_pool = 0;
+	std::vector<VkDescriptorPoolSize> pool_sizes;
+	std::vector<std::vector<VkDescriptorPool>> frame_pools;
+	std::vector<u32> current_pools;
+};
+
+// sizes_per_set is the worst case a single set needs, pools are sized for sets_per_pool of those
+bool create_descriptor_allocator(VkDevice device, u32 frame_count, u32 sets_per_pool, const std::vector<VkDescriptorPoolSize>& sizes_per_set,
+	descriptor_allocator& allocator);
+void destroy_descriptor_allocator(descriptor_allocator& allocator);
+
+// the frame's previous sets must no longer be in use by the gpu
+void reset_descriptor_frame(descriptor_allocator& allocator, u32 frame);
+
+// returns VK_NULL_HANDLE when even a fresh pool cannot hold the set
+VkDescriptorSet allocate_descriptor_set(descriptor_allocator& allocator, u32 frame, VkDescriptorSetLayout layout);
+
+// one set, bound once per frame, holding every storage buffer shaders reach through an index in their push
+// constants, so adding materials never adds binds or allocations. with descriptor indexing the set is partially
+// bound and update after bind, so slots can change while frames using it are in flight. without it every slot
+// has to point at a valid buffer, free slots point at the fallback buffer and slots may only change while the gpu is idle
+struct resource_table
+{
+	VkDevice device = VK_NULL_HANDLE;
+	bool update_after_bind = false;
+	u32 capacity = 0;
+	VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	VkBuffer fallback_buffer = VK_NULL_HANDLE;
+	std::vector<u32> free_slots;
+	u32 next_slot = 0;
+};
+
+bool create_resource_table(VkDevice device, u32 capacity, VkShaderStageFlags stages, bool update_after_bind, resource_table& table);
+void destroy_resource_table(resource_table& table);
+
+// must be set before the table is first bound, slots released later fall back to it as well
+void set_resource_table_fallback(resource_table& table, VkBuffer fallback_buffer);
+
+// returns the slot shaders index the buffer range with, or nullval when the table is full
+u32 register_storage_buffer(resource_table& table, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+void release_storage_buffer(resource_table& table, u32 slot);
@@ -0,0 +1,88 @@
+#include "filewatcher.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <iostream>
+
+bool start_file_watcher(file_watcher& watcher, const char* directory)
+{
+	watcher = file_watcher{};
+
+#ifdef _WIN32
+	HANDLE change_handle = FindFirstChangeNotificationA(directory, FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+	if (change_handle == INVALID_HANDLE_VALUE)
+	{
+		std::cout << "failed to watch " << directory << "!" << std::endl;
+		return false;
+	}
+	watcher.change_handle = change_handle;
+#else
+	watcher.inotify_descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watcher.inotify_descriptor < 0)
+	{
+		std::cout << "failed to initialize inotify!" << std::endl;
+		return false;
+	}
+
+	// compilers either rewrite the file in place or move a finished file over it
+	watcher.watch_descriptor = inotify_add_watch(watcher.inotify_descriptor, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (watcher.watch_descriptor < 0)
+	{
+		std::cout << "failed to watch " << directory << "!" << std::endl;
+		close(watcher.inotify_descriptor);
+		watcher = file_watcher{};
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+void stop_file_watcher(file_watcher& watcher)
+{
+#ifdef _WIN32
+	if (watcher.change_handle)
+	{
+		FindCloseChangeNotification(watcher.change_handle);
+	}
+#else
+	if (watcher.inotify_descriptor >= 0)
+	{
+		close(watcher.inotify_descriptor);
+	}
+#endif
+	watcher = file_watcher{};
+}
+
+bool poll_file_watcher(file_watcher& watcher)
+{
+#ifdef _WIN32
+	if (!watcher.change_handle || WaitForSingleObject(watcher.change_handle, 0) != WAIT_OBJECT_0)
+	{
+		return false;
+	}
+	FindNextChangeNotification(watcher.change_handle);
+	return true;
+#else
+	if (watcher.inotify_descriptor < 0)
+	{
+		return false;
+	}
+
+	// drain every queued event, the caller only cares that something changed
+	bool changed = false;
+	alignas(inotify_event) char events[4096];
+	while (read(watcher.inotify_descriptor, events, sizeof(events)) > 0)
+	{
+		changed = true;
+	}
+	return changed;
+#endif
+}
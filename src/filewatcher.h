@@ -0,0 +1,21 @@
+#pragma once
+
+#include "vulkancommon.h"
+
+// non-blocking change notifications for the files directly inside one directory,
+// FindFirstChangeNotification on windows and inotify on linux
+struct file_watcher
+{
+#ifdef _WIN32
+	void* change_handle = nullptr;
+#else
+	int inotify_descriptor = -1;
+	int watch_descriptor = -1;
+#endif
+};
+
+bool start_file_watcher(file_watcher& watcher, const char* directory);
+void stop_file_watcher(file_watcher& watcher);
+
+// true when anything in the directory was written since the last poll, never blocks
+bool poll_file_watcher(file_watcher& watcher);
@@ -0,0 +1,284 @@
+#include "frametiming.h"
+
+#include <json/json.h>
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+
+const char* frame_phase_name(frame_phase phase)
+{
+	switch (phase)
+	{
+	case frame_phase::fence_wait: return "fence_wait";
+	case frame_phase::cull: return "cull";
+	case frame_phase::acquire: return "acquire";
+	case frame_phase::record: return "record";
+	case frame_phase::submit: return "submit";
+	case frame_phase::present: return "present";
+	default: return "unknown";
+	}
+}
+
+void create_frame_timing_log(frame_timing_log& log, u32 capacity)
+{
+	log.frames = std::vector<frame_timing>(std::max(capacity, 1u));
+}
+
+frame_timing& begin_frame_timing(frame_timing_log& log, u64 frame_number, double start_time)
+{
+	frame_timing& timing = log.frames[frame_number % log.frames.size()];
+	timing = frame_timing{};
+	timing.frame_number = frame_number;
+	timing.start_time = start_time;
+	return timing;
+}
+
+frame_timing* find_frame_timing(frame_timing_log& log, u64 frame_number)
+{
+	frame_timing& timing = log.frames[frame_number % log.frames.size()];
+	return timing.frame_number == frame_number ? &timing : nullptr;
+}
+
+std::vector<const frame_timing*> get_frame_timings(const frame_timing_log& log)
+{
+	std::vector<const frame_timing*> timings;
+	for (const frame_timing& timing : log.frames)
+	{
+		if (timing.frame_number != 0)
+		{
+			timings.push_back(&timing);
+		}
+	}
+	std::sort(timings.begin(), timings.end(), [](const frame_timing* a, const frame_timing* b) { return a->frame_number < b->frame_number; });
+	return timings;
+}
+
+void print_frame_timing_summary(const frame_timing_log& log)
+{
+	std::vector<const frame_timing*> timings = get_frame_timings(log);
+	if (timings.empty())
+	{
+		return;
+	}
+
+	double phase_totals[(u32)frame_phase::count] = {};
+	double gpu_total = 0.0;
+	u32 gpu_count = 0;
+	for (const frame_timing* timing : timings)
+	{
+		for (u32 phase = 0; phase < (u32)frame_phase::count; phase++)
+		{
+			phase_totals[phase] += timing->phase_times[phase];
+		}
+		if (timing->gpu_time >= 0.0)
+		{
+			gpu_total += timing->gpu_time;
+			gpu_count++;
+		}
+	}
+
+	std::cout << "frame timing over the last " << timings.size() << " frames (avg ms):";
+	for (u32 phase = 0; phase < (u32)frame_phase::count; phase++)
+	{
+		std::cout << " " << frame_phase_name((frame_phase)phase) << " " << phase_totals[phase] * 1000.0 / timings.size();
+	}
+	if (gpu_count > 0)
+	{
+		std::cout << " gpu " << gpu_total * 1000.0 / gpu_count;
+	}
+	std::cout << std::endl;
+
+	// waiting on the fence means the gpu is behind, waiting in acquire or present means the swap chain is
+	double cpu_work = phase_totals[(u32)frame_phase::cull] + phase_totals[(u32)frame_phase::record] + phase_totals[(u32)frame_phase::submit];
+	double gpu_wait = phase_totals[(u32)frame_phase::fence_wait];
+	double present_wait = phase_totals[(u32)frame_phase::acquire] + phase_totals[(u32)frame_phase::present];
+	const char* bound = "cpu";
+	if (gpu_wait > cpu_work && gpu_wait >= present_wait)
+		bound = "gpu";
+	else if (present_wait > cpu_work && present_wait > gpu_wait)
+		bound = "present";
+	std::cout << "frame loop is mostly " << bound << "-bound" << std::endl;
+}
+
+bool export_frame_timing_csv(const frame_timing_log& log, const char* path)
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		std::cout << "failed to open frame timing file " << path << "!" << std::endl;
+		return false;
+	}
+
+	file << "frame,start_ms";
+	for (u32 phase = 0; phase < (u32)frame_phase::count; phase++)
+	{
+		file << "," << frame_phase_name((frame_phase)phase) << "_ms";
+	}
+	file << ",gpu_ms\n";
+
+	for (const frame_timing* timing : get_frame_timings(log))
+	{
+		file << timing->frame_number << "," << timing->start_time * 1000.0;
+		for (u32 phase = 0; phase < (u32)frame_phase::count; phase++)
+		{
+			file << "," << timing->phase_times[phase] * 1000.0;
+		}
+		file << ",";
+		if (timing->gpu_time >= 0.0)
+		{
+			file << timing->gpu_time * 1000.0;
+		}
+		file << "\n";
+	}
+
+	return true;
+}
+
+bool export_frame_timing_trace(const frame_timing_log& log, const char* path)
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		std::cout << "failed to open frame timing file " << path << "!" << std::endl;
+		return false;
+	}
+
+	nlohmann::json events = nlohmann::json::array();
+	for (const frame_timing* timing : get_frame_timings(log))
+	{
+		double event_start = timing->start_time;
+		double submit_end = event_start;
+		for (u32 phase = 0; phase < (u32)frame_phase::count; phase++)
+		{
+			events.push_back({
+				{ "name", frame_phase_name((frame_phase)phase) },
+				{ "cat", "cpu" },
+				{ "ph", "X" },
+				{ "ts", event_start * 1000000.0 },
+				{ "dur", timing->phase_times[phase] * 1000000.0 },
+				{ "pid", 0 },
+				{ "tid", 0 },
+				{ "args", { { "frame", timing->frame_number } } }
+			});
+			event_start += timing->phase_times[phase];
+			if ((frame_phase)phase == frame_phase::submit)
+			{
+				submit_end = event_start;
+			}
+		}
+
+		// gpu timestamps are in a different time domain, so only the duration is real and the event starts at submit
+		if (timing->gpu_time >= 0.0)
+		{
+			events.push_back({
+				{ "name", "render_pass" },
+				{ "cat", "gpu" },
+				{ "ph", "X" },
+				{ "ts", submit_end * 1000000.0 },
+				{ "dur", timing->gpu_time * 1000000.0 },
+				{ "pid", 0 },
+				{ "tid", 1 },
+				{ "args", { { "frame", timing->frame_number } } }
+			});
+		}
+	}
+
+	nlohmann::json trace = {
+		{ "traceEvents", events },
+		{ "displayTimeUnit", "ms" }
+	};
+	file << trace.dump();
+
+	return true;
+}
+
+bool create_gpu_timer(VkDevice device, VkPhysicalDevice physical_device, u32 queue_family, u32 frame_count, gpu_timer& timer)
+{
+	timer = gpu_timer{};
+
+	u32 queue_family_count = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+	std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+
+	u32 valid_bits = queue_family < queue_family_count ? queue_families[queue_family].timestampValidBits : 0;
+	if (valid_bits == 0)
+	{
+		std::cout << "queue family does not support timestamps, gpu timing disabled" << std::endl;
+		return true;
+	}
+
+	VkPhysicalDeviceProperties device_properties;
+	vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+	timer.timestamp_period = device_properties.limits.timestampPeriod;
+	timer.timestamp_mask = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+
+	VkQueryPoolCreateInfo query_pool_specification{};
+	query_pool_specification.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	query_pool_specification.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	query_pool_specification.queryCount = frame_count * 2;
+
+	if (vkCreateQueryPool(device, &query_pool_specification, nullptr, &timer.query_pool) != VK_SUCCESS)
+	{
+		std::cout << "failed to create timestamp query pool!" << std::endl;
+		timer.query_pool = VK_NULL_HANDLE;
+		return false;
+	}
+
+	timer.pending_frame_numbers = std::vector<u64>(frame_count, 0);
+	return true;
+}
+
+void destroy_gpu_timer(VkDevice device, gpu_timer& timer)
+{
+	if (timer.query_pool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(device, timer.query_pool, nullptr);
+	}
+	timer = gpu_timer{};
+}
+
+void write_gpu_timer_begin(const gpu_timer& timer, VkCommandBuffer command_buffer, u32 frame)
+{
+	if (timer.query_pool == VK_NULL_HANDLE)
+		return;
+
+	vkCmdResetQueryPool(command_buffer, timer.query_pool, frame * 2, 2);
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timer.query_pool, frame * 2);
+}
+
+void write_gpu_timer_end(const gpu_timer& timer, VkCommandBuffer command_buffer, u32 frame)
+{
+	if (timer.query_pool == VK_NULL_HANDLE)
+		return;
+
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timer.query_pool, frame * 2 + 1);
+}
+
+void resolve_gpu_timer(VkDevice device, gpu_timer& timer, u32 frame, frame_timing_log& log)
+{
+	if (timer.query_pool == VK_NULL_HANDLE || timer.pending_frame_numbers[frame] == 0)
+		return;
+
+	u64 timestamps[2] = {};
+	VkResult result = vkGetQueryPoolResults(device, timer.query_pool, frame * 2, 2, sizeof(timestamps), timestamps, sizeof(u64), VK_QUERY_RESULT_64_BIT);
+	if (result == VK_SUCCESS)
+	{
+		frame_timing* timing = find_frame_timing(log, timer.pending_frame_numbers[frame]);
+		if (timing)
+		{
+			u64 ticks = (timestamps[1] - timestamps[0]) & timer.timestamp_mask;
+			timing->gpu_time = ticks * timer.timestamp_period / 1000000000.0;
+		}
+	}
+	timer.pending_frame_numbers[frame] = 0;
+}
+
+void mark_gpu_timer_pending(gpu_timer& timer, u32 frame, u64 frame_number)
+{
+	if (timer.query_pool == VK_NULL_HANDLE)
+		return;
+
+	timer.pending_frame_numbers[frame] = frame_number;
+}
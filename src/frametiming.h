@@ -0,0 +1,71 @@
+#pragma once
+
+#include "vulkancommon.h"
+
+#include <vector>
+
+// cpu phases of one iteration of the render loop, in the order they run
+enum class frame_phase
+{
+	fence_wait,
+	cull,
+	acquire,
+	record,
+	submit,
+	present,
+	count
+};
+
+const char* frame_phase_name(frame_phase phase);
+
+// all times are in seconds, gpu_time stays negative until the timestamps of the frame have been read back
+struct frame_timing
+{
+	u64 frame_number = 0;
+	double start_time = 0.0;
+	double phase_times[(u32)frame_phase::count] = {};
+	double gpu_time = -1.0;
+};
+
+// ring buffer holding the most recent frames, indexed by frame number
+struct frame_timing_log
+{
+	std::vector<frame_timing> frames;
+};
+
+void create_frame_timing_log(frame_timing_log& log, u32 capacity);
+
+// starts a new entry for frame_number, overwriting the oldest one once the ring is full
+frame_timing& begin_frame_timing(frame_timing_log& log, u64 frame_number, double start_time);
+
+// returns nullptr once the frame has been overwritten
+frame_timing* find_frame_timing(frame_timing_log& log, u64 frame_number);
+
+// frames still in the ring, oldest first
+std::vector<const frame_timing*> get_frame_timings(const frame_timing_log& log);
+
+void print_frame_timing_summary(const frame_timing_log& log);
+
+// csv has one row per frame, the trace is chrome://tracing json with cpu phases on one track and gpu time on another
+bool export_frame_timing_csv(const frame_timing_log& log, const char* path);
+bool export_frame_timing_trace(const frame_timing_log& log, const char* path);
+
+// gpu timestamps come from two queries per frame in flight written around the render pass
+struct gpu_timer
+{
+	VkQueryPool query_pool = VK_NULL_HANDLE;
+	double timestamp_period = 0.0;
+	u64 timestamp_mask = 0;
+	std::vector<u64> pending_frame_numbers;
+};
+
+// leaves query_pool null when the queue family cannot write timestamps
+bool create_gpu_timer(VkDevice device, VkPhysicalDevice physical_device, u32 queue_family, u32 frame_count, gpu_timer& timer);
+void destroy_gpu_timer(VkDevice device, gpu_timer& timer);
+
+void write_gpu_timer_begin(const gpu_timer& timer, VkCommandBuffer command_buffer, u32 frame);
+void write_gpu_timer_end(const gpu_timer& timer, VkCommandBuffer command_buffer, u32 frame);
+
+// call after the fence of frame has been waited on, then again once its new work is submitted
+void resolve_gpu_timer(VkDevice device, gpu_timer& timer, u32 frame, frame_timing_log& log);
+void mark_gpu_timer_pending(gpu_timer& timer, u32 frame, u64 frame_number);
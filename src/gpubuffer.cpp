@@ -0,0 +1,77 @@
+#include "gpubuffer.h"
+
+#include <iostream>
+
+u32 find_memory_type(VkPhysicalDevice physical_device, u32 memory_type_bits, VkMemoryPropertyFlags properties)
+{
+	VkPhysicalDeviceMemoryProperties memory_properties;
+	vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+
+	for (u32 i = 0; i < memory_properties.memoryTypeCount; i++)
+	{
+		if ((memory_type_bits & (1 << i)) && (memory_properties.memoryTypes[i].propertyFlags & properties) == properties)
+		{
+			return i;
+		}
+	}
+
+	return nullval;
+}
+
+bool create_buffer(VkDevice device, device_memory_allocator& allocator, VkDeviceSize size, VkBufferUsageFlags usage,
+	VkMemoryPropertyFlags properties, const std::vector<u32>& queue_families, gpu_buffer& buffer)
+{
+	VkBufferCreateInfo buffer_specification{};
+	buffer_specification.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_specification.size = size;
+	buffer_specification.usage = usage;
+	if (queue_families.size() > 1)
+	{
+		buffer_specification.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		buffer_specification.queueFamilyIndexCount = (u32)queue_families.size();
+		buffer_specification.pQueueFamilyIndices = queue_families.data();
+	}
+	else
+	{
+		buffer_specification.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	}
+
+	if (vkCreateBuffer(device, &buffer_specification, nullptr, &buffer.buffer) != VK_SUCCESS)
+	{
+		std::cout << "failed to create buffer!" << std::endl;
+		return false;
+	}
+
+	VkMemoryRequirements memory_requirements;
+	vkGetBufferMemoryRequirements(device, buffer.buffer, &memory_requirements);
+
+	if (!allocate_memory(allocator, memory_requirements, properties, true, buffer.allocation))
+	{
+		std::cout << "failed to allocate buffer memory!" << std::endl;
+		vkDestroyBuffer(device, buffer.buffer, nullptr);
+		buffer.buffer = VK_NULL_HANDLE;
+		return false;
+	}
+
+	if (vkBindBufferMemory(device, buffer.buffer, buffer.allocation.memory, buffer.allocation.offset) != VK_SUCCESS)
+	{
+		std::cout << "failed to bind buffer memory!" << std::endl;
+		free_memory(allocator, buffer.allocation);
+		vkDestroyBuffer(device, buffer.buffer, nullptr);
+		buffer.buffer = VK_NULL_HANDLE;
+		return false;
+	}
+	buffer.size = size;
+
+	return true;
+}
+
+void destroy_buffer(VkDevice device, device_memory_allocator& allocator, gpu_buffer& buffer)
+{
+	if (buffer.buffer != VK_NULL_HANDLE)
+	{
+		vkDestroyBuffer(device, buffer.buffer, nullptr);
+	}
+	free_memory(allocator, buffer.allocation);
+	buffer = gpu_buffer{};
+}
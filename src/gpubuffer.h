@@ -0,0 +1,21 @@
+#pragma once
+
+#include "vulkancommon.h"
+#include "memoryallocator.h"
+
+#include <vector>
+
+struct gpu_buffer
+{
+	VkBuffer buffer = VK_NULL_HANDLE;
+	memory_allocation allocation;
+	VkDeviceSize size = 0;
+};
+
+// returns nullval when no memory type in memory_type_bits has all of the requested properties
+u32 find_memory_type(VkPhysicalDevice physical_device, u32 memory_type_bits, VkMemoryPropertyFlags properties);
+
+bool create_buffer(VkDevice device, device_memory_allocator& allocator, VkDeviceSize size, VkBufferUsageFlags usage,
+	VkMemoryPropertyFlags properties, const std::vector<u32>& queue_families, gpu_buffer& buffer);
+void destroy_buffer(VkDevice device, device_memory_allocator& allocator, gpu_buffer& buffer);
+
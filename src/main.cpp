@@ -1,8 +1,32 @@
+#ifdef _WIN32
 #define VK_USE_PLATFORM_WIN32_KHR
+#endif
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#ifdef _WIN32
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3native.h>
+#endif
+
+#include "vulkancommon.h"
+#include "pipelinecache.h"
+#include "presentpolicy.h"
+#include "memoryallocator.h"
+#include "gpubuffer.h"
+#include "workerpool.h"
+#include "frametiming.h"
+#include "benchmark.h"
+#include "shadercache.h"
+#include "filewatcher.h"
+#include "pipelineregistry.h"
+#include "culling.h"
+#include "descriptors.h"
+#include "uploadarena.h"
+#include "timeline.h"
+#include "uploadengine.h"
+#include "rendergraph.h"
+
+#include <glm/glm.hpp>
 
 #include <stdint.h>
 #include <iostream>
@@ -12,15 +36,119 @@
 #include <set>
 #include <algorithm>
 #include <fstream>
+#include <string>
+#include <atomic>
+#include <cmath>
+#include <chrono>
+#include <future>
+#include <cstring>
+
+struct vertex
+{
+	glm::vec2 position;
+	glm::vec3 color;
+};
+
+const std::vector<vertex> triangle_vertices = {
+	{ { 0.0f, -0.5f }, { 1.0f, 0.0f, 0.0f } },
+	{ { 0.5f, 0.5f }, { 0.0f, 1.0f, 0.0f } },
+	{ { -0.5f, 0.5f }, { 0.0f, 0.0f, 1.0f } }
+};
+
+const std::vector<u32> triangle_indices = {
+	0, 1, 2
+};
+
+// per-instance attributes, consumed at instance rate from vertex binding 1
+struct instance
+{
+	// x and y in clip space, z is the depth the instance is drawn at
+	glm::vec3 offset;
+	float scale;
+	glm::vec3 color;
+};
 
-typedef uint32_t u32;
-constexpr u32 nullval = 4294967295;
+// the gpu culling shader reads instances as packed floats
+static_assert(sizeof(instance) == 7 * sizeof(float), "cull.comp expects 7 floats per instance");
+
+struct draw_command
+{
+	u32 index_count;
+	u32 first_index;
+	int32_t vertex_offset;
+	u32 instance_count;
+	u32 first_instance;
+	// depth of the nearest instance, draws are sorted on it front to back
+	float depth;
+	// resource table slot of the draw's material, pushed before the draw
+	u32 material;
+};
 
 void process_input(GLFWwindow* window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+
+bool framebuffer_resized = false;
 
 const u32 window_width = 800;
 const u32 window_height = 600;
 
+const u32 max_frames_in_flight = 8;
+const u32 max_recording_threads = 64;
+const u32 max_instance_count = 64 * 1024 * 1024;
+const u32 max_layers = 256;
+// coarse enough to rasterize a few thousand occluders per frame, fine enough to hide small triangles
+const u32 occlusion_buffer_width = 256;
+const u32 occlusion_buffer_height = 192;
+const u32 max_occluder_triangles = 8192;
+// the resource table and the materials array in shader.vert have to agree on this
+const u32 max_material_count = 128;
+// one set per frame today, a pool only grows when a frame allocates more than this
+const u32 descriptor_sets_per_pool = 16;
+const u32 max_msaa_samples = 8;
+const u32 default_headless_frame_count = 300;
+const u32 min_timing_frames = 16;
+const u32 default_benchmark_frame_count = 1000;
+
+const char* shader_directory = "shaders";
+const char* vertex_shader_path = "shaders/vert.spv";
+const char* fragment_shader_path = "shaders/frag.spv";
+const char* cull_shader_path = "shaders/cull.spv";
+const u32 cull_workgroup_size = 64;
+const u32 max_workgroup_count = 65535;
+// compile.bat writes both modules back to back, so a reload waits for the directory to settle first
+const double shader_reload_delay = 0.25;
+
+const char* pipeline_cache_path = "pipeline_cache.bin";
+
+struct launch_options
+{
+	u32 frames_in_flight = 2;
+	bool static_scene = false;
+	present_profile present = present_profile::low_latency;
+	u32 recording_threads = 0;
+	u32 draw_count = 1;
+	u32 instance_count = 1;
+	u32 layers = 1;
+	bool depth_prepass = false;
+	float camera_zoom = 1.0f;
+	bool animate_camera = false;
+	bool occlusion_cull = false;
+	bool gpu_cull = false;
+	u32 material_count = 1;
+	bool dynamic_rendering = false;
+	u32 msaa_samples = 1;
+	bool headless = false;
+	u64 frame_limit = 0;
+	std::string output_path;
+	u32 timing_frames = 1024;
+	std::string timing_output_path;
+	std::string benchmark_scenario_name;
+	u64 warmup_frames = 100;
+	double duration = 0.0;
+	std::string benchmark_output_path;
+	bool hot_reload = true;
+};
+
 const std::vector<const char*> validation_layers = {
 	"VK_LAYER_KHRONOS_validation"
 };
@@ -46,40 +174,272 @@ VKAPI_ATTR VkBool32 VKAPI_CALL debug_message_callback(
 	return VK_FALSE;
 }
 
-int main()
+bool parse_launch_options(int argc, char** argv, launch_options& options)
+{
+	bool present_profile_set = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument == "--frames-in-flight" && i + 1 < argc)
+		{
+			options.frames_in_flight = std::clamp((u32)std::strtoul(argv[++i], nullptr, 10), 1u, max_frames_in_flight);
+		}
+		else if (argument == "--static-scene")
+		{
+			options.static_scene = true;
+		}
+		else if (argument == "--recording-threads" && i + 1 < argc)
+		{
+			options.recording_threads = std::min((u32)std::strtoul(argv[++i], nullptr, 10), max_recording_threads);
+		}
+		else if (argument == "--draws" && i + 1 < argc)
+		{
+			options.draw_count = std::max((u32)std::strtoul(argv[++i], nullptr, 10), 1u);
+		}
+		else if (argument == "--instances" && i + 1 < argc)
+		{
+			options.instance_count = std::clamp((u32)std::strtoul(argv[++i], nullptr, 10), 1u, max_instance_count);
+		}
+		else if (argument == "--layers" && i + 1 < argc)
+		{
+			options.layers = std::clamp((u32)std::strtoul(argv[++i], nullptr, 10), 1u, max_layers);
+		}
+		else if (argument == "--depth-prepass")
+		{
+			options.depth_prepass = true;
+		}
+		else if (argument == "--camera-zoom" && i + 1 < argc)
+		{
+			options.camera_zoom = std::max(std::strtof(argv[++i], nullptr), 0.1f);
+		}
+		else if (argument == "--animate-camera")
+		{
+			options.animate_camera = true;
+		}
+		else if (argument == "--occlusion-cull")
+		{
+			options.occlusion_cull = true;
+		}
+		else if (argument == "--gpu-cull")
+		{
+			options.gpu_cull = true;
+		}
+		else if (argument == "--msaa" && i + 1 < argc)
+		{
+			options.msaa_samples = std::clamp((u32)std::strtoul(argv[++i], nullptr, 10), 1u, max_msaa_samples);
+		}
+		else if (argument == "--dynamic-rendering")
+		{
+			options.dynamic_rendering = true;
+		}
+		else if (argument == "--materials" && i + 1 < argc)
+		{
+			options.material_count = std::clamp((u32)std::strtoul(argv[++i], nullptr, 10), 1u, max_material_count);
+		}
+		else if (argument == "--headless")
+		{
+			options.headless = true;
+		}
+		else if (argument == "--frames" && i + 1 < argc)
+		{
+			options.frame_limit = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (argument == "--output" && i + 1 < argc)
+		{
+			options.output_path = argv[++i];
+		}
+		else if (argument == "--timing-frames" && i + 1 < argc)
+		{
+			options.timing_frames = std::max((u32)std::strtoul(argv[++i], nullptr, 10), min_timing_frames);
+		}
+		else if (argument == "--timing-output" && i + 1 < argc)
+		{
+			options.timing_output_path = argv[++i];
+		}
+		else if (argument == "--no-hot-reload")
+		{
+			options.hot_reload = false;
+		}
+		else if (argument == "--benchmark" && i + 1 < argc)
+		{
+			options.benchmark_scenario_name = argv[++i];
+		}
+		else if (argument == "--warmup" && i + 1 < argc)
+		{
+			options.warmup_frames = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (argument == "--duration" && i + 1 < argc)
+		{
+			options.duration = std::max(std::strtod(argv[++i], nullptr), 0.0);
+		}
+		else if (argument == "--benchmark-output" && i + 1 < argc)
+		{
+			options.benchmark_output_path = argv[++i];
+		}
+		else if (argument == "--present-profile" && i + 1 < argc)
+		{
+			if (!parse_present_profile(argv[++i], options.present))
+			{
+				std::cout << "unknown present profile: " << argv[i] << " (expected low-latency, power-saving or throughput)" << std::endl;
+				return false;
+			}
+			present_profile_set = true;
+		}
+		else
+		{
+			std::cout << "unrecognized argument: " << argument << std::endl;
+			return false;
+		}
+	}
+
+	// the scenario owns the workload so results of one scenario are comparable across commits,
+	// --frames then counts measured frames after warmup and --duration replaces it when given
+	if (!options.benchmark_scenario_name.empty())
+	{
+		benchmark_scenario scenario;
+		if (!find_benchmark_scenario(options.benchmark_scenario_name, scenario))
+		{
+			std::cout << "unknown benchmark scenario: " << options.benchmark_scenario_name << std::endl;
+			print_benchmark_scenarios();
+			return false;
+		}
+		options.instance_count = scenario.instance_count;
+		options.draw_count = scenario.draw_count;
+		options.recording_threads = scenario.recording_threads;
+		options.static_scene = scenario.static_scene;
+		options.layers = scenario.layers;
+		options.depth_prepass = scenario.depth_prepass;
+		options.camera_zoom = scenario.camera_zoom;
+		options.animate_camera = scenario.animate_camera;
+		options.occlusion_cull = scenario.occlusion_cull;
+		options.gpu_cull = scenario.gpu_cull;
+		options.material_count = scenario.material_count;
+		options.dynamic_rendering = scenario.dynamic_rendering;
+		options.msaa_samples = scenario.msaa_samples;
+		if (!present_profile_set)
+		{
+			options.present = present_profile::throughput;
+		}
+		if (options.frame_limit == 0 && options.duration == 0.0)
+		{
+			options.frame_limit = default_benchmark_frame_count;
+		}
+	}
+
+	// the culled instances are drawn by one indirect draw with the first draw's data, so every instance would get
+	// material 0. checked after the scenario override, which sets both
+	if (options.gpu_cull && options.material_count > 1)
+	{
+		std::cout << "--gpu-cull draws every instance with one material and cannot be combined with --materials " << options.material_count << "!" << std::endl;
+		return false;
+	}
+
+	// nothing closes a headless run, so it always stops after a fixed number of frames
+	if (options.headless && options.frame_limit == 0 && options.duration == 0.0)
+	{
+		options.frame_limit = default_headless_frame_count;
+	}
+
+	return true;
+}
+
+// wall clock in seconds, kept independent of glfw so headless runs never have to initialize it
+double get_time()
+{
+	static const auto start_time = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+// lays the instances out on a square grid covering the viewport; a single instance is drawn untransformed.
+// with several layers the grid is stacked that many times, each layer nudged by a fraction of a cell so the
+// triangles overlap, and emitted back to front the way a painter's algorithm would draw them
+std::vector<instance> build_instance_grid(u32 instance_count, u32 layers)
 {
-	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-	glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+	std::vector<instance> instances(instance_count);
+	if (instance_count == 1)
+	{
+		instances[0] = { { 0.0f, 0.0f, 0.5f }, 1.0f, { 1.0f, 1.0f, 1.0f } };
+		return instances;
+	}
 
-	GLFWwindow* window = glfwCreateWindow(window_width, window_height, "vulkan", nullptr, nullptr);
-	if (!window)
+	layers = std::min(layers, instance_count);
+	u32 instances_per_layer = (instance_count + layers - 1) / layers;
+	u32 grid_size = (u32)std::ceil(std::sqrt((double)instances_per_layer));
+	float cell_size = 2.0f / grid_size;
+	for (u32 i = 0; i < instance_count; i++)
+	{
+		u32 layer = i / instances_per_layer;
+		u32 cell = i % instances_per_layer;
+		u32 column = cell % grid_size;
+		u32 row = cell / grid_size;
+		float jitter = cell_size * 0.5f * layer / layers;
+		float depth = 1.0f - (layer + 0.5f) / layers;
+
+		// cheap integer hash so neighbouring triangles get visibly different tints
+		u32 hash = i * 2654435761u;
+		instances[i].offset = { -1.0f + cell_size * (column + 0.5f) + jitter, -1.0f + cell_size * (row + 0.5f) + jitter, depth };
+		instances[i].scale = cell_size * 0.9f;
+		instances[i].color = { 0.5f + (hash & 0xff) / 510.0f, 0.5f + ((hash >> 8) & 0xff) / 510.0f, 0.5f + ((hash >> 16) & 0xff) / 510.0f };
+	}
+
+	return instances;
+}
+
+int main(int argc, char** argv)
+{
+	launch_options options;
+	if (!parse_launch_options(argc, argv, options))
 	{
-		std::cout << "could not create glfw window" << std::endl;
-		glfwTerminate();
 		return -1;
 	}
+	std::cout << "frames in flight: " << options.frames_in_flight << std::endl;
+
+	double startup_time = get_time();
+
+	// headless runs never touch glfw, so they work on machines without a display
+	GLFWwindow* window = nullptr;
+	if (options.headless)
+	{
+		std::cout << "headless: rendering " << options.frame_limit << " frames offscreen" << std::endl;
+	}
+	else
+	{
+		glfwInit();
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+
+		window = glfwCreateWindow(window_width, window_height, "vulkan", nullptr, nullptr);
+		if (!window)
+		{
+			std::cout << "could not create glfw window" << std::endl;
+			glfwTerminate();
+			return -1;
+		}
+		glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	}
 
 	VkInstance vulkan_instance;
 	VkApplicationInfo application_specification{};
-	VkApplicationInfo appInfo{};
 	application_specification.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
 	application_specification.pApplicationName = "Hello Triangle";
 	application_specification.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 	application_specification.pEngineName = "No Engine";
 	application_specification.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-	application_specification.apiVersion = VK_API_VERSION_1_0;
+	application_specification.apiVersion = VK_API_VERSION_1_3;
 
 
 	VkInstanceCreateInfo instance_specification{};
 	instance_specification.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-	instance_specification.pApplicationInfo = &appInfo;
+	instance_specification.pApplicationInfo = &application_specification;
 
 	u32 glfw_extension_count = 0;
-	const char** glfw_required_extensions;
-	glfw_required_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+	const char** glfw_required_extensions = nullptr;
+	if (!options.headless)
+	{
+		glfw_required_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+	}
 
 	std::vector<const char*> required_extensions(glfw_required_extensions, glfw_required_extensions + glfw_extension_count);
 	if (validation_layers_enabled)
@@ -197,28 +557,29 @@ int main()
 		}
 	}
 
-	VkSurfaceKHR surface;
+	VkSurfaceKHR surface = VK_NULL_HANDLE;
+	if (!options.headless)
+	{
 #if 0
 
-	VkWin32SurfaceCreateInfoKHR surface_specification{};
-	surface_specification.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
-	surface_specification.hwnd = glfwGetWin32Window(window);
-	surface_specification.hinstance = GetModuleHandle(nullptr);
+		VkWin32SurfaceCreateInfoKHR surface_specification{};
+		surface_specification.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
+		surface_specification.hwnd = glfwGetWin32Window(window);
+		surface_specification.hinstance = GetModuleHandle(nullptr);
 
-	if (vkCreateWin32SurfaceKHR(vulkan_instance, &surface_specification, nullptr, &surface) != VK_SUCCESS)
-	{
-		std::cout << "failed to create window surface!" << std::endl;
-		return -1;
-	}
+		if (vkCreateWin32SurfaceKHR(vulkan_instance, &surface_specification, nullptr, &surface) != VK_SUCCESS)
+		{
+			std::cout << "failed to create window surface!" << std::endl;
+			return -1;
+		}
 #else
-	if (glfwCreateWindowSurface(vulkan_instance, window, nullptr, &surface) != VK_SUCCESS)
-	{
-		std::cout << "failed to create window surface!" << std::endl;
-		return -1;
-	}
+		if (glfwCreateWindowSurface(vulkan_instance, window, nullptr, &surface) != VK_SUCCESS)
+		{
+			std::cout << "failed to create window surface!" << std::endl;
+			return -1;
+		}
 #endif
-
-
+	}
 
 	VkPhysicalDevice physical_device = VK_NULL_HANDLE;
 
@@ -233,7 +594,9 @@ int main()
 	struct queue_family_indices
 	{
 		u32 graphics_family = nullval;
+		bool graphics_has_compute = false;
 		u32 present_family = nullval;
+		u32 transfer_family = nullval;
 	};
 	queue_family_indices indices;
 
@@ -249,25 +612,31 @@ int main()
 
 		std::cout << "queue family count: " << queue_family_count << std::endl;
 
+		indices = queue_family_indices{};
 		int i = 0;
 		for (const auto& family : queue_families)
 		{
-			if (family.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+			if ((family.queueFlags & VK_QUEUE_GRAPHICS_BIT) && indices.graphics_family == nullval)
 			{
 				indices.graphics_family = i;
+				indices.graphics_has_compute = (family.queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
 			}
 
 			VkBool32 present_support = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present_support);
+			if (surface != VK_NULL_HANDLE)
+			{
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present_support);
+			}
 
-			if (present_support)
+			if (present_support && indices.present_family == nullval)
 			{
 				indices.present_family = i;
 			}
 
-			if (indices.graphics_family != nullval && indices.present_family != nullval)
+			// a transfer family without graphics or compute is usually backed by a dedicated copy engine
+			if ((family.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(family.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) && indices.transfer_family == nullval)
 			{
-				break;
+				indices.transfer_family = i;
 			}
 
 			i++;
@@ -286,7 +655,13 @@ int main()
 	std::vector<VkExtensionProperties> available_extensions_set(extension_count_set);
 	vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count_set, available_extensions_set.data());
 
-	std::set<std::string> required_extensions_set(device_extensions.begin(), device_extensions.end());
+	// offscreen rendering needs no swap chain, so a headless device enables no extensions at all
+	std::vector<const char*> enabled_device_extensions;
+	if (!options.headless)
+	{
+		enabled_device_extensions = device_extensions;
+	}
+	std::set<std::string> required_extensions_set(enabled_device_extensions.begin(), enabled_device_extensions.end());
 
 	for (const auto& extension : available_extensions_set)
 	{
@@ -300,70 +675,56 @@ int main()
 		std::vector<VkPresentModeKHR> present_modes;
 	};
 
-	swap_chain_support_details swap_chain_support;
-
-	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, surface, &swap_chain_support.capabilities);
-
-	u32 format_count;
-	vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &format_count, nullptr);
-
-	if (format_count != 0)
+	swap_chain_support_details swap_chain_support{};
+	VkSurfaceFormatKHR preferred_format{};
+	VkPresentModeKHR preferred_present_mode = VK_PRESENT_MODE_FIFO_KHR;
+	if (!options.headless)
 	{
-		swap_chain_support.formats.resize(format_count);
-		vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &format_count, swap_chain_support.formats.data());
-	}
+		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, surface, &swap_chain_support.capabilities);
 
-	u32 present_mode_count;
-	vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_mode_count, nullptr);
+		u32 format_count;
+		vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &format_count, nullptr);
 
-	if (present_mode_count != 0)
-	{
-		swap_chain_support.present_modes.resize(present_mode_count);
-		vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_mode_count, swap_chain_support.present_modes.data());
-	}
+		if (format_count != 0)
+		{
+			swap_chain_support.formats.resize(format_count);
+			vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &format_count, swap_chain_support.formats.data());
+		}
 
+		u32 present_mode_count;
+		vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_mode_count, nullptr);
 
-	VkSurfaceFormatKHR preferred_format;
-	for (const auto& available_format : swap_chain_support.formats)
-	{
-		if (available_format.format == VK_FORMAT_B8G8R8A8_SRGB && available_format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+		if (present_mode_count != 0)
 		{
-			preferred_format = available_format;
-			break;
+			swap_chain_support.present_modes.resize(present_mode_count);
+			vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_mode_count, swap_chain_support.present_modes.data());
 		}
-	}
-	if (!&preferred_format)
-	{
-		std::cout << "failed to select preferred surface format!" << std::endl;
-		return -1;
-	}
 
-	VkPresentModeKHR preferred_present_mode;
-	for (const auto& available_present_mode : swap_chain_support.present_modes)
-	{
-		if (available_present_mode == VK_PRESENT_MODE_MAILBOX_KHR)
+		if (swap_chain_support.formats.size() < 1)
 		{
-			preferred_present_mode = available_present_mode;
-			break;
+			std::cout << "failed to select preferred surface format!" << std::endl;
+			return -1;
 		}
-	}
-	if (swap_chain_support.present_modes.size() < 1)
-	{
-		std::cout << "present modes unavailable!" << std::endl;
-		return -1;
-	}
-	if (!&preferred_present_mode)
-	{
-		preferred_present_mode = swap_chain_support.present_modes[0];
-		std::cout << "mailbox mode unsupported, selecting default instead: MODE" << preferred_present_mode << std::endl;
-	}
-	if (!&preferred_present_mode)
-	{
-		std::cout << "failed to select preferred present mode!" << std::endl;
-		return -1;
+		preferred_format = swap_chain_support.formats[0];
+		for (const auto& available_format : swap_chain_support.formats)
+		{
+			if (available_format.format == VK_FORMAT_B8G8R8A8_SRGB && available_format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+			{
+				preferred_format = available_format;
+				break;
+			}
+		}
+
+		if (swap_chain_support.present_modes.size() < 1)
+		{
+			std::cout << "present modes unavailable!" << std::endl;
+			return -1;
+		}
+		preferred_present_mode = select_present_mode(options.present, swap_chain_support.present_modes);
+		std::cout << "present profile: " << present_profile_name(options.present) << ", present mode: " << present_mode_name(preferred_present_mode) << std::endl;
 	}
 
-	if (physical_device == VK_NULL_HANDLE || !required_extensions_set.empty() || swap_chain_support.formats.empty() || swap_chain_support.present_modes.empty())
+	if (physical_device == VK_NULL_HANDLE || !required_extensions_set.empty() || (!options.headless && (swap_chain_support.formats.empty() || swap_chain_support.present_modes.empty())))
 	{
 		std::cout << "failed to find a suitable GPU!" << std::endl;
 		return -1;
@@ -379,36 +740,172 @@ int main()
 		std::cout << "graphics family uninitialized!" << std::endl;
 		return -1;
 	}
+	if (options.headless)
+	{
+		indices.present_family = indices.graphics_family;
+	}
 	if (indices.present_family == nullval)
 	{
-		std::cout << "graphics family uninitialized!" << std::endl;
+		std::cout << "present family uninitialized!" << std::endl;
 		return -1;
 	}
 	VkDevice device;
 
 	std::vector<VkDeviceQueueCreateInfo> queue_specification_vector;
 	std::set<u32> unique_queue_families = { indices.graphics_family, indices.present_family };
+	if (indices.transfer_family != nullval)
+	{
+		unique_queue_families.insert(indices.transfer_family);
+	}
 
 	float queue_priority = 1.0f;
 	for (u32 queue_family : unique_queue_families)
 	{
 		VkDeviceQueueCreateInfo queue_specification{};
 		queue_specification.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-		queue_specification.queueFamilyIndex = indices.graphics_family;
+		queue_specification.queueFamilyIndex = queue_family;
 		queue_specification.queueCount = 1;
 		queue_specification.pQueuePriorities = &queue_priority;
 		queue_specification_vector.push_back(queue_specification);
 	}
 
+	// timeline semaphores and descriptor indexing are core in 1.2, devices without descriptor indexing fall back to
+	// a fully written resource table. a 1.1 device gets timeline semaphores from VK_KHR_timeline_semaphore and
+	// always uses the fallback table, the 1.2 feature struct may not even be chained there
+	VkPhysicalDeviceProperties physical_device_properties;
+	vkGetPhysicalDeviceProperties(physical_device, &physical_device_properties);
+	bool vulkan_1_2_supported = physical_device_properties.apiVersion >= VK_API_VERSION_1_2;
+	bool timeline_semaphore_extension_supported = false;
+	for (const auto& extension : available_extensions_set)
+	{
+		if (strcmp(extension.extensionName, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) == 0)
+		{
+			timeline_semaphore_extension_supported = true;
+		}
+	}
+	if (!vulkan_1_2_supported && !timeline_semaphore_extension_supported)
+	{
+		std::cout << "failed to find a GPU with Vulkan 1.2 or " << VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME << ", frame synchronization needs timeline semaphores!" << std::endl;
+		return -1;
+	}
+	if (!vulkan_1_2_supported)
+	{
+		enabled_device_extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+	}
+
+	VkPhysicalDeviceVulkan12Features supported_vulkan_1_2_features{};
+	supported_vulkan_1_2_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	VkPhysicalDeviceTimelineSemaphoreFeatures supported_timeline_semaphore_features{};
+	supported_timeline_semaphore_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+	VkPhysicalDeviceFeatures2 supported_features{};
+	supported_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	if (vulkan_1_2_supported)
+	{
+		supported_features.pNext = &supported_vulkan_1_2_features;
+	}
+	else
+	{
+		supported_features.pNext = &supported_timeline_semaphore_features;
+	}
+
+	// the 1.3 features may only be queried from a 1.3 device
+	VkPhysicalDeviceVulkan13Features supported_vulkan_1_3_features{};
+	supported_vulkan_1_3_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+	if (physical_device_properties.apiVersion >= VK_API_VERSION_1_3)
+	{
+		supported_vulkan_1_2_features.pNext = &supported_vulkan_1_3_features;
+	}
+
+	VkPhysicalDeviceDescriptorIndexingProperties descriptor_indexing_properties{};
+	descriptor_indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+	vkGetPhysicalDeviceFeatures2(physical_device, &supported_features);
+
+	VkPhysicalDeviceProperties2 properties{};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	if (vulkan_1_2_supported)
+	{
+		properties.pNext = &descriptor_indexing_properties;
+	}
+	vkGetPhysicalDeviceProperties2(physical_device, &properties);
+
+	if (!supported_vulkan_1_2_features.timelineSemaphore && !supported_timeline_semaphore_features.timelineSemaphore)
+	{
+		std::cout << "failed to find a GPU with timeline semaphore support!" << std::endl;
+		return -1;
+	}
+
+	bool descriptor_indexing_supported = supported_vulkan_1_2_features.descriptorBindingPartiallyBound &&
+		supported_vulkan_1_2_features.descriptorBindingStorageBufferUpdateAfterBind &&
+		descriptor_indexing_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers >= max_material_count;
+	if (!descriptor_indexing_supported && physical_device_properties.limits.maxPerStageDescriptorStorageBuffers < max_material_count)
+	{
+		std::cout << "failed to find a GPU that can bind " << max_material_count << " storage buffers per stage!" << std::endl;
+		return -1;
+	}
+
+	// the highest sample count up to the requested one that both color and depth attachments support,
+	// sample counts are powers of two and VkSampleCountFlagBits uses the count as its bit
+	VkSampleCountFlags supported_sample_counts = physical_device_properties.limits.framebufferColorSampleCounts & physical_device_properties.limits.framebufferDepthSampleCounts;
+	u32 msaa_sample_count = 1;
+	while (msaa_sample_count * 2 <= options.msaa_samples && (supported_sample_counts & (msaa_sample_count * 2)))
+	{
+		msaa_sample_count *= 2;
+	}
+	if (msaa_sample_count != options.msaa_samples)
+	{
+		std::cout << "GPU supports " << msaa_sample_count << "x MSAA at most, requested " << options.msaa_samples << "x" << std::endl;
+	}
+	VkSampleCountFlagBits msaa_samples = (VkSampleCountFlagBits)msaa_sample_count;
+	bool multisampled = msaa_samples != VK_SAMPLE_COUNT_1_BIT;
+
+	// shader.vert indexes the material array with the draw's material index, read from the draw data at the pushed
+	// draw index, which is dynamically uniform indexing. every desktop driver supports it, without it only material 0 is used
 	VkPhysicalDeviceFeatures device_features{};
+	device_features.shaderStorageBufferArrayDynamicIndexing = supported_features.features.shaderStorageBufferArrayDynamicIndexing;
+	if (!device_features.shaderStorageBufferArrayDynamicIndexing)
+	{
+		options.material_count = 1;
+	}
+
+	VkPhysicalDeviceVulkan12Features vulkan_1_2_features{};
+	vulkan_1_2_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	vulkan_1_2_features.descriptorBindingPartiallyBound = descriptor_indexing_supported ? VK_TRUE : VK_FALSE;
+	vulkan_1_2_features.descriptorBindingStorageBufferUpdateAfterBind = descriptor_indexing_supported ? VK_TRUE : VK_FALSE;
+	vulkan_1_2_features.timelineSemaphore = VK_TRUE;
+
+	if (options.dynamic_rendering && !supported_vulkan_1_3_features.dynamicRendering)
+	{
+		std::cout << "GPU has no Vulkan 1.3 dynamic rendering, using render passes" << std::endl;
+		options.dynamic_rendering = false;
+	}
+
+	VkPhysicalDeviceVulkan13Features vulkan_1_3_features{};
+	vulkan_1_3_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+	vulkan_1_3_features.dynamicRendering = VK_TRUE;
+	if (options.dynamic_rendering)
+	{
+		vulkan_1_2_features.pNext = &vulkan_1_3_features;
+	}
+
+	VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features{};
+	timeline_semaphore_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+	timeline_semaphore_features.timelineSemaphore = VK_TRUE;
 
 	VkDeviceCreateInfo device_specification{};
 	device_specification.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	if (vulkan_1_2_supported)
+	{
+		device_specification.pNext = &vulkan_1_2_features;
+	}
+	else
+	{
+		device_specification.pNext = &timeline_semaphore_features;
+	}
 	device_specification.queueCreateInfoCount = (u32)queue_specification_vector.size();
 	device_specification.pQueueCreateInfos = queue_specification_vector.data();
 	device_specification.pEnabledFeatures = &device_features;
-	device_specification.enabledExtensionCount = (u32)device_extensions.size();
-	device_specification.ppEnabledExtensionNames = device_extensions.data();
+	device_specification.enabledExtensionCount = (u32)enabled_device_extensions.size();
+	device_specification.ppEnabledExtensionNames = enabled_device_extensions.data();
 
 	if (validation_layers_enabled)
 	{
@@ -432,298 +929,395 @@ int main()
 	vkGetDeviceQueue(device, indices.graphics_family, 0, &graphics_queue);
 	vkGetDeviceQueue(device, indices.present_family, 0, &present_queue);
 
-	VkExtent2D preferred_swap_extent;
-	if (swap_chain_support.capabilities.currentExtent.width != nullval)
-	{
-		preferred_swap_extent = swap_chain_support.capabilities.currentExtent;
-	}
-	else
+	VkQueue transfer_queue = graphics_queue;
+	if (indices.transfer_family != nullval)
 	{
-		int width, height;
-		glfwGetFramebufferSize(window, &width, &height);
-
-		VkExtent2D actual_extent = {
-			(u32)width,
-			(u32)height
-		};
-
-		actual_extent.width = std::clamp(actual_extent.width, swap_chain_support.capabilities.minImageExtent.width, swap_chain_support.capabilities.maxImageExtent.width);
-		actual_extent.height = std::clamp(actual_extent.height, swap_chain_support.capabilities.minImageExtent.height, swap_chain_support.capabilities.maxImageExtent.height);
-
-		preferred_swap_extent = actual_extent;
+		vkGetDeviceQueue(device, indices.transfer_family, 0, &transfer_queue);
+		std::cout << "dedicated transfer queue family: " << indices.transfer_family << std::endl;
 	}
 
-	u32 image_count = swap_chain_support.capabilities.minImageCount + 1;
-
-	if (swap_chain_support.capabilities.maxImageCount > 0 && image_count > swap_chain_support.capabilities.maxImageCount)
-		image_count = swap_chain_support.capabilities.minImageCount;
-
-	VkSwapchainCreateInfoKHR swap_chain_specification{};
-	swap_chain_specification.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-	swap_chain_specification.surface = surface;
-	swap_chain_specification.minImageCount = image_count;
-	swap_chain_specification.imageFormat = preferred_format.format;
-	swap_chain_specification.imageColorSpace = preferred_format.colorSpace;
-	swap_chain_specification.imageExtent = preferred_swap_extent;
-	swap_chain_specification.imageArrayLayers = 1;
-	swap_chain_specification.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-
-	if (indices.graphics_family != indices.present_family)
-	{
-		swap_chain_specification.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-		swap_chain_specification.queueFamilyIndexCount = sizeof(queue_family_indices) / 4;
-		swap_chain_specification.pQueueFamilyIndices = &indices.graphics_family;
-	}
-	else
+	// one timeline per queue that is submitted to, presents only wait on binary semaphores and need none.
+	// without a dedicated transfer queue uploads go to the graphics queue and share its timeline
+	queue_timeline graphics_timeline;
+	queue_timeline transfer_timeline;
+	if (!create_queue_timeline(device, graphics_timeline) || (transfer_queue != graphics_queue && !create_queue_timeline(device, transfer_timeline)))
 	{
-		swap_chain_specification.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-		swap_chain_specification.queueFamilyIndexCount = 0;
-		swap_chain_specification.pQueueFamilyIndices = nullptr;
+		return -1;
 	}
+	queue_timeline& upload_timeline = transfer_queue != graphics_queue ? transfer_timeline : graphics_timeline;
 
-	swap_chain_specification.preTransform = swap_chain_support.capabilities.currentTransform;
-	swap_chain_specification.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-	swap_chain_specification.presentMode = preferred_present_mode;
-	swap_chain_specification.clipped = VK_TRUE;
-	swap_chain_specification.oldSwapchain = VK_NULL_HANDLE;
+	device_memory_allocator memory_allocator;
+	create_memory_allocator(device, physical_device, memory_allocator);
 
-	VkSwapchainKHR swap_chain;
+	VkSwapchainKHR swap_chain = VK_NULL_HANDLE;
 	std::vector<VkImage> swap_chain_images;
 	VkFormat swap_chain_image_format;
 	VkExtent2D swap_chain_extent;
+	std::vector<VkImageView> swap_chain_image_views;
 
-	if (vkCreateSwapchainKHR(device, &swap_chain_specification, nullptr, &swap_chain) != VK_SUCCESS)
+	auto create_image_views = [&]() -> bool
 	{
-		std::cout << "failed to create swap chain!" << std::endl;
-		return -1;
-	}
+		swap_chain_image_views = std::vector<VkImageView>(swap_chain_images.size());
+
+		for (size_t i = 0; i < swap_chain_images.size(); i++) {
+			VkImageViewCreateInfo image_view_specification{};
+			image_view_specification.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			image_view_specification.image = swap_chain_images[i];
+			image_view_specification.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			image_view_specification.format = swap_chain_image_format;
+			image_view_specification.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+			image_view_specification.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+			image_view_specification.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+			image_view_specification.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+			image_view_specification.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			image_view_specification.subresourceRange.baseMipLevel = 0;
+			image_view_specification.subresourceRange.levelCount = 1;
+			image_view_specification.subresourceRange.baseArrayLayer = 0;
+			image_view_specification.subresourceRange.layerCount = 1;
+
+			if (vkCreateImageView(device, &image_view_specification, nullptr, &swap_chain_image_views[i]) != VK_SUCCESS) {
+				std::cout << "failed to create image views!" << std::endl;
+				return false;
+			}
+		}
 
-	vkGetSwapchainImagesKHR(device, swap_chain, &image_count, nullptr);
-	swap_chain_images.resize(image_count);
-	vkGetSwapchainImagesKHR(device, swap_chain, &image_count, swap_chain_images.data());
+		return true;
+	};
 
-	swap_chain_image_format = preferred_format.format;
-	swap_chain_extent = preferred_swap_extent;
+	auto create_swap_chain = [&](VkSwapchainKHR old_swap_chain) -> bool
+	{
+		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, surface, &swap_chain_support.capabilities);
 
+		VkExtent2D preferred_swap_extent;
+		if (swap_chain_support.capabilities.currentExtent.width != nullval)
+		{
+			preferred_swap_extent = swap_chain_support.capabilities.currentExtent;
+		}
+		else
+		{
+			int width, height;
+			glfwGetFramebufferSize(window, &width, &height);
 
-	std::vector<VkImageView> swap_chain_image_views(swap_chain_images.size());
+			VkExtent2D actual_extent = {
+				(u32)width,
+				(u32)height
+			};
 
-	for (size_t i = 0; i < swap_chain_images.size(); i++) {
-		VkImageViewCreateInfo image_view_specification{};
-		image_view_specification.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-		image_view_specification.image = swap_chain_images[i];
-		image_view_specification.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		image_view_specification.format = swap_chain_image_format;
-		image_view_specification.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-		image_view_specification.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-		image_view_specification.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-		image_view_specification.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-		image_view_specification.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		image_view_specification.subresourceRange.baseMipLevel = 0;
-		image_view_specification.subresourceRange.levelCount = 1;
-		image_view_specification.subresourceRange.baseArrayLayer = 0;
-		image_view_specification.subresourceRange.layerCount = 1;
+			actual_extent.width = std::clamp(actual_extent.width, swap_chain_support.capabilities.minImageExtent.width, swap_chain_support.capabilities.maxImageExtent.width);
+			actual_extent.height = std::clamp(actual_extent.height, swap_chain_support.capabilities.minImageExtent.height, swap_chain_support.capabilities.maxImageExtent.height);
 
-		if (vkCreateImageView(device, &image_view_specification, nullptr, &swap_chain_image_views[i]) != VK_SUCCESS) {
-			std::cout << "failed to create image views!" << std::endl;
-			return -1;
+			preferred_swap_extent = actual_extent;
 		}
-	}
 
+		u32 image_count = select_swap_chain_image_count(options.present, preferred_present_mode, swap_chain_support.capabilities);
+
+		VkSwapchainCreateInfoKHR swap_chain_specification{};
+		swap_chain_specification.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+		swap_chain_specification.surface = surface;
+		swap_chain_specification.minImageCount = image_count;
+		swap_chain_specification.imageFormat = preferred_format.format;
+		swap_chain_specification.imageColorSpace = preferred_format.colorSpace;
+		swap_chain_specification.imageExtent = preferred_swap_extent;
+		swap_chain_specification.imageArrayLayers = 1;
+		swap_chain_specification.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+		u32 swap_chain_queue_families[] = { indices.graphics_family, indices.present_family };
+		if (indices.graphics_family != indices.present_family)
+		{
+			swap_chain_specification.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+			swap_chain_specification.queueFamilyIndexCount = 2;
+			swap_chain_specification.pQueueFamilyIndices = swap_chain_queue_families;
+		}
+		else
+		{
+			swap_chain_specification.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			swap_chain_specification.queueFamilyIndexCount = 0;
+			swap_chain_specification.pQueueFamilyIndices = nullptr;
+		}
+
+		swap_chain_specification.preTransform = swap_chain_support.capabilities.currentTransform;
+		swap_chain_specification.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+		swap_chain_specification.presentMode = preferred_present_mode;
+		swap_chain_specification.clipped = VK_TRUE;
+		swap_chain_specification.oldSwapchain = old_swap_chain;
+
+		if (vkCreateSwapchainKHR(device, &swap_chain_specification, nullptr, &swap_chain) != VK_SUCCESS)
+		{
+			std::cout << "failed to create swap chain!" << std::endl;
+			return false;
+		}
+
+		vkGetSwapchainImagesKHR(device, swap_chain, &image_count, nullptr);
+		swap_chain_images.resize(image_count);
+		vkGetSwapchainImagesKHR(device, swap_chain, &image_count, swap_chain_images.data());
+
+		swap_chain_image_format = preferred_format.format;
+		swap_chain_extent = preferred_swap_extent;
+
+		return create_image_views();
+	};
+
+	// headless runs render into plain images instead, one per frame in flight so frames still overlap
+	std::vector<memory_allocation> offscreen_allocations;
+
+	auto create_offscreen_targets = [&]() -> bool
+	{
+		const VkFormat candidate_formats[] = { VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM };
+		swap_chain_image_format = VK_FORMAT_UNDEFINED;
+		for (VkFormat format : candidate_formats)
+		{
+			VkFormatProperties format_properties;
+			vkGetPhysicalDeviceFormatProperties(physical_device, format, &format_properties);
+			if (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT)
+			{
+				swap_chain_image_format = format;
+				break;
+			}
+		}
+		if (swap_chain_image_format == VK_FORMAT_UNDEFINED)
+		{
+			std::cout << "failed to find an offscreen color format!" << std::endl;
+			return false;
+		}
+
+		swap_chain_extent = { window_width, window_height };
+		swap_chain_images = std::vector<VkImage>(options.frames_in_flight, VK_NULL_HANDLE);
+		offscreen_allocations = std::vector<memory_allocation>(options.frames_in_flight);
+
+		for (size_t i = 0; i < swap_chain_images.size(); i++)
+		{
+			VkImageCreateInfo image_specification{};
+			image_specification.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			image_specification.imageType = VK_IMAGE_TYPE_2D;
+			image_specification.format = swap_chain_image_format;
+			image_specification.extent = { swap_chain_extent.width, swap_chain_extent.height, 1 };
+			image_specification.mipLevels = 1;
+			image_specification.arrayLayers = 1;
+			image_specification.samples = VK_SAMPLE_COUNT_1_BIT;
+			image_specification.tiling = VK_IMAGE_TILING_OPTIMAL;
+			image_specification.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			image_specification.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			image_specification.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			if (vkCreateImage(device, &image_specification, nullptr, &swap_chain_images[i]) != VK_SUCCESS)
+			{
+				std::cout << "failed to create offscreen image!" << std::endl;
+				return false;
+			}
+
+			VkMemoryRequirements memory_requirements;
+			vkGetImageMemoryRequirements(device, swap_chain_images[i], &memory_requirements);
+			if (!allocate_memory(memory_allocator, memory_requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, offscreen_allocations[i]) ||
+				vkBindImageMemory(device, swap_chain_images[i], offscreen_allocations[i].memory, offscreen_allocations[i].offset) != VK_SUCCESS)
+			{
+				std::cout << "failed to allocate offscreen image memory!" << std::endl;
+				return false;
+			}
+		}
+
+		return create_image_views();
+	};
+
+	if (options.headless ? !create_offscreen_targets() : !create_swap_chain(VK_NULL_HANDLE))
+	{
+		return -1;
+	}
+
+	// the first format the device can depth test against, 32 bit float gives the best precision
+	const VkFormat candidate_depth_formats[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM };
+	VkFormat depth_format = VK_FORMAT_UNDEFINED;
+	for (VkFormat format : candidate_depth_formats)
+	{
+		VkFormatProperties format_properties;
+		vkGetPhysicalDeviceFormatProperties(physical_device, format, &format_properties);
+		if (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+		{
+			depth_format = format;
+			break;
+		}
+	}
+	if (depth_format == VK_FORMAT_UNDEFINED)
+	{
+		std::cout << "failed to find a depth format!" << std::endl;
+		return -1;
+	}
+
+	// the frame is a render graph that is rebuilt with the swap chain. the depth buffer is one of its transients,
+	// and every layout transition and barrier between the passes comes out of the graph
+	render_graph frame_graph;
+	u32 graph_color_target = nullval;
+	u32 graph_msaa_color_target = nullval;
+	u32 graph_depth_target = nullval;
+	u32 graph_visible_instances = nullval;
+	u32 graph_indirect_draws = nullval;
+	u32 graph_visible_count = nullval;
+
+
+	// with MSAA the color attachment is the multisampled image, its samples are never stored
 	VkAttachmentDescription color_attachment{};
 	color_attachment.format = swap_chain_image_format;
-	color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	color_attachment.samples = msaa_samples;
 	color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	color_attachment.storeOp = multisampled ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
 	color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	// the frame graph moves the attachments in and out of their attachment layouts, so the render pass leaves them alone
+	color_attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	color_attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	// depth only lives for the pass, so it is never loaded or stored
+	VkAttachmentDescription depth_attachment{};
+	depth_attachment.format = depth_format;
+	depth_attachment.samples = msaa_samples;
+	depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depth_attachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depth_attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	// the subpass resolves into the swap chain image as it ends, which is the only color written to memory
+	VkAttachmentDescription resolve_attachment{};
+	resolve_attachment.format = swap_chain_image_format;
+	resolve_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	resolve_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	resolve_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	resolve_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	resolve_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	resolve_attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	resolve_attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentDescription attachments[] = { color_attachment, depth_attachment, resolve_attachment };
 
 	VkAttachmentReference color_attachment_reference{};
 	color_attachment_reference.attachment = 0;
 	color_attachment_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+	VkAttachmentReference depth_attachment_reference{};
+	depth_attachment_reference.attachment = 1;
+	depth_attachment_reference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference resolve_attachment_reference{};
+	resolve_attachment_reference.attachment = 2;
+	resolve_attachment_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
 	VkSubpassDescription subpass{};
 	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 	subpass.colorAttachmentCount = 1;
 	subpass.pColorAttachments = &color_attachment_reference;
+	subpass.pResolveAttachments = multisampled ? &resolve_attachment_reference : nullptr;
+	subpass.pDepthStencilAttachment = &depth_attachment_reference;
 
-	VkRenderPass render_pass;
+	// dynamic rendering begins directly on the image views, so it needs neither a render pass nor framebuffers
+	VkRenderPass render_pass = VK_NULL_HANDLE;
 	VkPipelineLayout pipeline_layout;
 
 	VkRenderPassCreateInfo render_pass_specification{};
 	render_pass_specification.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	render_pass_specification.attachmentCount = 1;
-	render_pass_specification.pAttachments = &color_attachment;
+	render_pass_specification.attachmentCount = multisampled ? 3 : 2;
+	render_pass_specification.pAttachments = attachments;
 	render_pass_specification.subpassCount = 1;
 	render_pass_specification.pSubpasses = &subpass;
+	render_pass_specification.dependencyCount = 0;
 
-	if (vkCreateRenderPass(device, &render_pass_specification, nullptr, &render_pass) != VK_SUCCESS)
+	if (!options.dynamic_rendering && vkCreateRenderPass(device, &render_pass_specification, nullptr, &render_pass) != VK_SUCCESS)
 	{
 		std::cout << "failed to create render pass!" << std::endl;
+		return -1;
 	}
 
 
 
-	std::ifstream vert_file("shaders/vert.spv", std::ios::ate | std::ios::binary);
-	if (!vert_file.is_open())
-	{
-		std::cout << "failed to open vertex shader file!" << std::endl;
-		return -1;
-	}
-	size_t vert_file_size = (size_t)vert_file.tellg();
-	std::vector<char> vert_file_buffer(vert_file_size);
-	vert_file.seekg(0);
-	vert_file.read(vert_file_buffer.data(), vert_file_size);
-	vert_file.close();
+	shader_module_cache shader_modules;
+	create_shader_module_cache(device, shader_modules);
 
-	std::ifstream frag_file("shaders/frag.spv", std::ios::ate | std::ios::binary);
-	if (!frag_file.is_open())
+	VkShaderModule vertex_shader_module = load_shader_module(shader_modules, vertex_shader_path);
+	VkShaderModule fragment_shader_module = load_shader_module(shader_modules, fragment_shader_path);
+	if (vertex_shader_module == VK_NULL_HANDLE || fragment_shader_module == VK_NULL_HANDLE)
 	{
-		std::cout << "failed to open fragment shader file!" << std::endl;
 		return -1;
 	}
-	size_t frag_file_size = (size_t)frag_file.tellg();
-	std::vector<char> frag_file_buffer(frag_file_size);
-	frag_file.seekg(0);
-	frag_file.read(frag_file_buffer.data(), frag_file_size);
-	frag_file.close();
-
-	std::cout << "VERTEX/FRAGMENT SHADERS SUCCESSFULLY LOADED: " << std::endl
-		<< "vertex shader file size: " << vert_file_size << std::endl
-		<< "fragment shader file size: " << frag_file_size << std::endl;
 
-	VkShaderModuleCreateInfo fragment_shader_module_specification{};
-	fragment_shader_module_specification.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	fragment_shader_module_specification.codeSize = frag_file_size;
-	fragment_shader_module_specification.pCode = reinterpret_cast<const u32*>(frag_file_buffer.data());
+	std::cout << "VERTEX/SHADER MODULES SUCCESSFULLY CREATED" << std::endl;
 
-	VkShaderModule fragment_shader_module;
-	if (vkCreateShaderModule(device, &fragment_shader_module_specification, nullptr, &fragment_shader_module) != VK_SUCCESS)
+	std::vector<VkVertexInputBindingDescription> vertex_binding_descriptions(2);
+	vertex_binding_descriptions[0].binding = 0;
+	vertex_binding_descriptions[0].stride = sizeof(vertex);
+	vertex_binding_descriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	vertex_binding_descriptions[1].binding = 1;
+	vertex_binding_descriptions[1].stride = sizeof(instance);
+	vertex_binding_descriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+	std::vector<VkVertexInputAttributeDescription> vertex_attribute_descriptions(5);
+	vertex_attribute_descriptions[0].binding = 0;
+	vertex_attribute_descriptions[0].location = 0;
+	vertex_attribute_descriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+	vertex_attribute_descriptions[0].offset = offsetof(vertex, position);
+	vertex_attribute_descriptions[1].binding = 0;
+	vertex_attribute_descriptions[1].location = 1;
+	vertex_attribute_descriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+	vertex_attribute_descriptions[1].offset = offsetof(vertex, color);
+	vertex_attribute_descriptions[2].binding = 1;
+	vertex_attribute_descriptions[2].location = 2;
+	vertex_attribute_descriptions[2].format = VK_FORMAT_R32G32B32_SFLOAT;
+	vertex_attribute_descriptions[2].offset = offsetof(instance, offset);
+	vertex_attribute_descriptions[3].binding = 1;
+	vertex_attribute_descriptions[3].location = 3;
+	vertex_attribute_descriptions[3].format = VK_FORMAT_R32_SFLOAT;
+	vertex_attribute_descriptions[3].offset = offsetof(instance, scale);
+	vertex_attribute_descriptions[4].binding = 1;
+	vertex_attribute_descriptions[4].location = 4;
+	vertex_attribute_descriptions[4].format = VK_FORMAT_R32G32B32_SFLOAT;
+	vertex_attribute_descriptions[4].offset = offsetof(instance, color);
+
+	// set 0 is the resource table, bound once per command buffer whatever the material count. set 1 holds the
+	// frame constants and the per draw constants of the frame, both in the upload arena at dynamic offsets.
+	// it comes from the frame's descriptor pools, draws only differ in the draw index they push
+	resource_table resources;
+	if (!create_resource_table(device, max_material_count, VK_SHADER_STAGE_VERTEX_BIT, descriptor_indexing_supported, resources))
 	{
-		std::cout << "failed to create fragment shader module!" << std::endl;
 		return -1;
 	}
 
-	VkShaderModuleCreateInfo vertex_shader_module_specification{};
-	vertex_shader_module_specification.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	vertex_shader_module_specification.codeSize = vert_file_size;
-	vertex_shader_module_specification.pCode = reinterpret_cast<const u32*>(vert_file_buffer.data());
-
-	VkShaderModule vertex_shader_module;
-	if (vkCreateShaderModule(device, &vertex_shader_module_specification, nullptr, &vertex_shader_module) != VK_SUCCESS)
+	VkDescriptorSetLayoutBinding frame_set_bindings[2]{};
+	frame_set_bindings[0].binding = 0;
+	frame_set_bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frame_set_bindings[0].descriptorCount = 1;
+	frame_set_bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	frame_set_bindings[1].binding = 1;
+	frame_set_bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	frame_set_bindings[1].descriptorCount = 1;
+	frame_set_bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+	VkDescriptorSetLayoutCreateInfo frame_set_layout_specification{};
+	frame_set_layout_specification.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	frame_set_layout_specification.bindingCount = 2;
+	frame_set_layout_specification.pBindings = frame_set_bindings;
+
+	VkDescriptorSetLayout frame_set_layout;
+	if (vkCreateDescriptorSetLayout(device, &frame_set_layout_specification, nullptr, &frame_set_layout) != VK_SUCCESS)
 	{
-		std::cout << "failed to create vertex shader module!" << std::endl;
+		std::cout << "failed to create frame descriptor set layout!" << std::endl;
 		return -1;
 	}
 
-	std::cout << "VERTEX/SHADER MODULES SUCCESSFULLY CREATED" << std::endl;
-
-	VkPipelineShaderStageCreateInfo vertex_shader_stage_specification{};
-	vertex_shader_stage_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	vertex_shader_stage_specification.stage = VK_SHADER_STAGE_VERTEX_BIT;
-	vertex_shader_stage_specification.module = vertex_shader_module;
-	vertex_shader_stage_specification.pName = "main";
-
-	VkPipelineShaderStageCreateInfo fragment_shader_stage_specification{};
-	fragment_shader_stage_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	fragment_shader_stage_specification.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	fragment_shader_stage_specification.module = fragment_shader_module;
-	fragment_shader_stage_specification.pName = "main";
-
-	VkPipelineShaderStageCreateInfo shader_stages[] = { vertex_shader_stage_specification, fragment_shader_stage_specification };
-
-	std::vector<VkDynamicState> dynamic_states = {
-		VK_DYNAMIC_STATE_VIEWPORT,
-		VK_DYNAMIC_STATE_SCISSOR
-	};
-
-	VkPipelineDynamicStateCreateInfo dynamic_state_specification{};
-	dynamic_state_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-	dynamic_state_specification.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
-	dynamic_state_specification.pDynamicStates = dynamic_states.data();
-
-	VkPipelineVertexInputStateCreateInfo vertex_input_specification{};
-	vertex_input_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertex_input_specification.vertexBindingDescriptionCount = 0;
-	vertex_input_specification.pVertexBindingDescriptions = nullptr;
-	vertex_input_specification.vertexAttributeDescriptionCount = 0;
-	vertex_input_specification.pVertexAttributeDescriptions = nullptr;
-
-	VkPipelineInputAssemblyStateCreateInfo input_assembly_specification{};
-	input_assembly_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	input_assembly_specification.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-	input_assembly_specification.primitiveRestartEnable = VK_FALSE;
-
-	VkViewport viewport{};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = (float)swap_chain_extent.width;
-	viewport.height = (float)swap_chain_extent.height;
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-
-	VkRect2D scissor{};
-	scissor.offset = { 0, 0 };
-	scissor.extent = swap_chain_extent;
-
-	VkPipelineViewportStateCreateInfo viewport_state_specification{};
-	viewport_state_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-	viewport_state_specification.viewportCount = 1;
-	viewport_state_specification.pViewports = &viewport;
-	viewport_state_specification.scissorCount = 1;
-	viewport_state_specification.pScissors = &scissor;
-
-	VkPipelineRasterizationStateCreateInfo rasterizer{};
-	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-	rasterizer.depthClampEnable = VK_FALSE;
-	rasterizer.rasterizerDiscardEnable = VK_FALSE;
-	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-	rasterizer.lineWidth = 1.0f;
-	rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-	rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-	rasterizer.depthBiasEnable = VK_FALSE;
-	rasterizer.depthBiasConstantFactor = 0.0f;
-	rasterizer.depthBiasClamp = 0.0f;
-	rasterizer.depthBiasSlopeFactor = 0.0f;
-
-	VkPipelineMultisampleStateCreateInfo multisampling_specification{};
-	multisampling_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-	multisampling_specification.sampleShadingEnable = VK_FALSE;
-	multisampling_specification.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-	multisampling_specification.minSampleShading = 1.0f;
-	multisampling_specification.pSampleMask = nullptr;
-	multisampling_specification.alphaToCoverageEnable = VK_FALSE;
-	multisampling_specification.alphaToOneEnable = VK_FALSE;
-
-	VkPipelineColorBlendAttachmentState color_blend_attachment_specification{};
-	color_blend_attachment_specification.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-	color_blend_attachment_specification.blendEnable = VK_FALSE;
-	color_blend_attachment_specification.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-	color_blend_attachment_specification.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-	color_blend_attachment_specification.colorBlendOp = VK_BLEND_OP_ADD;
-	color_blend_attachment_specification.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-	color_blend_attachment_specification.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-	color_blend_attachment_specification.alphaBlendOp = VK_BLEND_OP_ADD;
-
-	VkPipelineColorBlendStateCreateInfo color_blend_specification{};
-	color_blend_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-	color_blend_specification.logicOpEnable = VK_FALSE;
-	color_blend_specification.logicOp = VK_LOGIC_OP_COPY;
-	color_blend_specification.attachmentCount = 1;
-	color_blend_specification.pAttachments = &color_blend_attachment_specification;
-	color_blend_specification.blendConstants[0] = 0.0f;
-	color_blend_specification.blendConstants[1] = 0.0f;
-	color_blend_specification.blendConstants[2] = 0.0f;
-	color_blend_specification.blendConstants[3] = 0.0f;
+	struct draw_constants
+	{
+		u32 draw_index;
+	};
 
+	VkDescriptorSetLayout set_layouts[] = { resources.layout, frame_set_layout };
 	VkPipelineLayoutCreateInfo pipeline_layout_specification{};
 	pipeline_layout_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipeline_layout_specification.setLayoutCount = 0;
-	pipeline_layout_specification.pSetLayouts = nullptr;
-	pipeline_layout_specification.pushConstantRangeCount = 0;
-	pipeline_layout_specification.pPushConstantRanges = nullptr;
+	pipeline_layout_specification.setLayoutCount = 2;
+	pipeline_layout_specification.pSetLayouts = set_layouts;
+	VkPushConstantRange draw_constants_range{};
+	draw_constants_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	draw_constants_range.offset = 0;
+	draw_constants_range.size = sizeof(draw_constants);
+
+	pipeline_layout_specification.pushConstantRangeCount = 1;
+	pipeline_layout_specification.pPushConstantRanges = &draw_constants_range;
 
 	if (vkCreatePipelineLayout(device, &pipeline_layout_specification, nullptr, &pipeline_layout) != VK_SUCCESS)
 	{
@@ -731,57 +1325,94 @@ int main()
 		return -1;
 	}
 
-	VkGraphicsPipelineCreateInfo pipeline_specification{};
-	pipeline_specification.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipeline_specification.stageCount = 2;
-	pipeline_specification.pStages = shader_stages;
-	pipeline_specification.pVertexInputState = &vertex_input_specification;
-	pipeline_specification.pInputAssemblyState = &input_assembly_specification;
-	pipeline_specification.pViewportState = &viewport_state_specification;
-	pipeline_specification.pRasterizationState = &rasterizer;
-	pipeline_specification.pMultisampleState = &multisampling_specification;
-	pipeline_specification.pDepthStencilState = nullptr;
-	pipeline_specification.pColorBlendState = &color_blend_specification;
-	pipeline_specification.pDynamicState = &dynamic_state_specification;
-	pipeline_specification.layout = pipeline_layout;
-	pipeline_specification.renderPass = render_pass;
-	pipeline_specification.subpass = 0;
-	pipeline_specification.basePipelineHandle = VK_NULL_HANDLE;
-	pipeline_specification.basePipelineIndex = -1;
-
-	VkPipeline graphics_pipeline;
-	if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeline_specification, nullptr, &graphics_pipeline) != VK_SUCCESS)
-	{
-		std::cout << "failed to create graphics pipeline!" << std::endl;
-		return -1;
-	}
+	VkPipelineCache pipeline_cache = create_pipeline_cache(device, physical_device, pipeline_cache_path);
+
+	pipeline_registry pipelines;
+	create_pipeline_registry(device, pipeline_cache, pipeline_layout, vertex_binding_descriptions, vertex_attribute_descriptions, pipelines);
 
-	vkDestroyShaderModule(device, fragment_shader_module, nullptr);
-	vkDestroyShaderModule(device, vertex_shader_module, nullptr);
+	pipeline_state graphics_pipeline_state;
+	graphics_pipeline_state.vertex_module = vertex_shader_module;
+	graphics_pipeline_state.fragment_module = fragment_shader_module;
+	graphics_pipeline_state.render_pass = render_pass;
+	graphics_pipeline_state.subpass = 0;
+	graphics_pipeline_state.color_format = swap_chain_image_format;
+	graphics_pipeline_state.depth_format = depth_format;
+	graphics_pipeline_state.samples = msaa_samples;
+	graphics_pipeline_state.depth_test = true;
 
-	std::vector<VkFramebuffer> swap_chain_frame_buffers(swap_chain_image_views.size());
+	// with a pre-pass the color pass only shades what survived it, LESS_OR_EQUAL rather than EQUAL keeps
+	// that robust against drivers that compile the vertex stage slightly differently per pipeline
+	graphics_pipeline_state.depth_write = !options.depth_prepass;
+	graphics_pipeline_state.depth_compare = options.depth_prepass ? VK_COMPARE_OP_LESS_OR_EQUAL : VK_COMPARE_OP_LESS;
 
-	for (size_t i = 0; i < swap_chain_image_views.size(); i++)
+	// the pre-pass is the color pipeline without a fragment stage or color writes, so it always follows it on reload
+	auto get_depth_prepass_state = [](pipeline_state state) -> pipeline_state
 	{
-		VkImageView attachments[] = {
-			swap_chain_image_views[i]
-		};
+		state.fragment_module = VK_NULL_HANDLE;
+		state.color_write_mask = 0;
+		state.depth_write = true;
+		state.depth_compare = VK_COMPARE_OP_LESS;
+		return state;
+	};
+
+	auto build_graphics_pipeline = [&](const pipeline_state& state, VkPipeline& pipeline) -> bool
+	{
+		double pipeline_start_time = get_time();
+		pipeline = get_pipeline(pipelines, state);
+		if (pipeline == VK_NULL_HANDLE)
+		{
+			return false;
+		}
+		std::cout << "graphics pipeline creation time: " << (get_time() - pipeline_start_time) * 1000.0 << " ms" << std::endl;
+		return true;
+	};
+
+	// the pipeline compiles on a background thread while buffers, command pools and sync objects are set up,
+	// everything it reads stays alive in this scope and the result is joined before the first command buffer is recorded
+	VkPipeline graphics_pipeline = VK_NULL_HANDLE;
+	VkPipeline depth_prepass_pipeline = VK_NULL_HANDLE;
+	std::future<bool> graphics_pipeline_compiled = std::async(std::launch::async, [&]() -> bool
+	{
+		return build_graphics_pipeline(graphics_pipeline_state, graphics_pipeline) &&
+			(!options.depth_prepass || build_graphics_pipeline(get_depth_prepass_state(graphics_pipeline_state), depth_prepass_pipeline));
+	});
 
-		VkFramebufferCreateInfo framebuffer_specification{};
-		framebuffer_specification.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		framebuffer_specification.renderPass = render_pass;
-		framebuffer_specification.attachmentCount = 1;
-		framebuffer_specification.pAttachments = attachments;
-		framebuffer_specification.width = swap_chain_extent.width;
-		framebuffer_specification.height = swap_chain_extent.height;
-		framebuffer_specification.layers = 1;
+	std::vector<VkFramebuffer> swap_chain_frame_buffers;
 
-		if (vkCreateFramebuffer(device, &framebuffer_specification, nullptr, &swap_chain_frame_buffers[i]) != VK_SUCCESS)
+	auto create_frame_buffers = [&]() -> bool
+	{
+		if (options.dynamic_rendering)
 		{
-			std::cout << "failed to create framebuffer!" << std::endl;
-			return -1;
+			return true;
 		}
-	}
+		swap_chain_frame_buffers = std::vector<VkFramebuffer>(swap_chain_image_views.size());
+
+		for (size_t i = 0; i < swap_chain_image_views.size(); i++)
+		{
+			VkImageView attachments[] = {
+				multisampled ? get_graph_image_view(frame_graph, graph_msaa_color_target) : swap_chain_image_views[i],
+				get_graph_image_view(frame_graph, graph_depth_target),
+				swap_chain_image_views[i]
+			};
+
+			VkFramebufferCreateInfo framebuffer_specification{};
+			framebuffer_specification.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			framebuffer_specification.renderPass = render_pass;
+			framebuffer_specification.attachmentCount = multisampled ? 3 : 2;
+			framebuffer_specification.pAttachments = attachments;
+			framebuffer_specification.width = swap_chain_extent.width;
+			framebuffer_specification.height = swap_chain_extent.height;
+			framebuffer_specification.layers = 1;
+
+			if (vkCreateFramebuffer(device, &framebuffer_specification, nullptr, &swap_chain_frame_buffers[i]) != VK_SUCCESS)
+			{
+				std::cout << "failed to create framebuffer!" << std::endl;
+				return false;
+			}
+		}
+
+		return true;
+	};
 
 	VkCommandPool command_pool;
 
@@ -796,192 +1427,1855 @@ int main()
 		return -1;
 	}
 
-	VkCommandBuffer command_buffer;
-
-	VkCommandBufferAllocateInfo command_buffer_allocation_specification{};
-	command_buffer_allocation_specification.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	command_buffer_allocation_specification.commandPool = command_pool;
-	command_buffer_allocation_specification.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	command_buffer_allocation_specification.commandBufferCount = 1;
-
-	if (vkAllocateCommandBuffers(device, &command_buffer_allocation_specification, &command_buffer) != VK_SUCCESS)
+	// startup data is queued and flushed as one batch on the transfer queue, nothing here waits for it to arrive
+	upload_engine uploads;
+	if (!create_upload_engine(device, memory_allocator, transfer_queue, indices.transfer_family != nullval ? indices.transfer_family : indices.graphics_family, upload_timeline,
+		graphics_queue, indices.graphics_family, graphics_timeline, uploads))
 	{
-		std::cout << "failed to allocate command buffers!" << std::endl;
 		return -1;
 	}
 
-	VkSemaphore image_available_semaphore;
-	VkSemaphore render_finished_semaphore;
-	VkFence in_flight_fence;
+	gpu_buffer vertex_buffer;
+	gpu_buffer index_buffer;
+	gpu_buffer instance_buffer;
+	if (!queue_buffer_upload(uploads, triangle_vertices.data(), sizeof(vertex) * triangle_vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, vertex_buffer) ||
+		!queue_buffer_upload(uploads, triangle_indices.data(), sizeof(u32) * triangle_indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT, index_buffer))
+	{
+		std::cout << "failed to upload geometry!" << std::endl;
+		return -1;
+	}
+	u32 index_count = (u32)triangle_indices.size();
+
+	// every material is its own range of one buffer and its own slot in the resource table, so a new material
+	// costs a descriptor write at load time and nothing per frame. material 0 stays white, it is also the fallback
+	VkDeviceSize material_alignment = std::max(physical_device_properties.limits.minStorageBufferOffsetAlignment, (VkDeviceSize)sizeof(glm::vec4));
+	VkDeviceSize material_stride = (sizeof(glm::vec4) + material_alignment - 1) / material_alignment * material_alignment;
+	gpu_buffer material_buffer;
+	std::vector<u32> material_slots;
+	{
+		std::vector<uint8_t> material_data(material_stride * options.material_count, 0);
+		for (u32 i = 0; i < options.material_count; i++)
+		{
+			u32 hash = i * 2246822519u;
+			glm::vec4 tint = i == 0 ? glm::vec4(1.0f) : glm::vec4(0.25f + (hash & 0xff) / 340.0f, 0.25f + ((hash >> 8) & 0xff) / 340.0f, 0.25f + ((hash >> 16) & 0xff) / 340.0f, 1.0f);
+			std::memcpy(&material_data[material_stride * i], &tint, sizeof(tint));
+		}
+		if (!queue_buffer_upload(uploads, material_data.data(), material_data.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, material_buffer))
+		{
+			std::cout << "failed to upload materials!" << std::endl;
+			return -1;
+		}
 
-	VkSemaphoreCreateInfo semaphore_specification{};
-	semaphore_specification.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		set_resource_table_fallback(resources, material_buffer.buffer);
+		for (u32 i = 0; i < options.material_count; i++)
+		{
+			material_slots.push_back(register_storage_buffer(resources, material_buffer.buffer, material_stride * i, sizeof(glm::vec4)));
+		}
+	}
 
-	VkFenceCreateInfo fence_specification{};
-	fence_specification.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fence_specification.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+	// gpu culling needs a compute capable graphics queue and the compiled cull shader, without either the cpu culls.
+	// static scenes record their command buffers per image, which cannot own per frame culling output
+	bool gpu_culling = options.gpu_cull && !options.static_scene;
+	VkShaderModule cull_shader_module = VK_NULL_HANDLE;
+	if (gpu_culling && !indices.graphics_has_compute)
+	{
+		std::cout << "graphics queue has no compute support, culling on the cpu" << std::endl;
+		gpu_culling = false;
+	}
+	if (gpu_culling)
+	{
+		cull_shader_module = load_shader_module(shader_modules, cull_shader_path);
+		if (cull_shader_module == VK_NULL_HANDLE)
+		{
+			std::cout << "cull shader unavailable (run shaders/compile.bat), culling on the cpu" << std::endl;
+			gpu_culling = false;
+		}
+	}
 
-	if (vkCreateSemaphore(device, &semaphore_specification, nullptr, &image_available_semaphore) != VK_SUCCESS ||
-		vkCreateSemaphore(device, &semaphore_specification, nullptr, &render_finished_semaphore) != VK_SUCCESS ||
-		vkCreateFence(device, &fence_specification, nullptr, &in_flight_fence) != VK_SUCCESS)
+	float triangle_radius = 0.0f;
+	for (const vertex& triangle_vertex : triangle_vertices)
 	{
-		std::cout << "failed to create semaphores!" << std::endl;
-		return -1;
+		triangle_radius = std::max(triangle_radius, glm::length(triangle_vertex.position));
 	}
 
+	std::vector<draw_command> draw_list;
+	cull_bounds draw_bounds;
+	std::vector<bounding_box> draw_boxes;
+	std::vector<instance> occluder_instances;
+	{
+		// instances are rasterized in order, so sorting them front to back lets early depth testing
+		// reject everything behind the first layer instead of shading it and overwriting it later
+		std::vector<instance> instances = build_instance_grid(options.instance_count, options.layers);
+		std::stable_sort(instances.begin(), instances.end(), [](const instance& a, const instance& b) { return a.offset.z < b.offset.z; });
+		VkBufferUsageFlags instance_usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | (gpu_culling ? VK_BUFFER_USAGE_STORAGE_BUFFER_BIT : 0);
+		VkPipelineStageFlags instance_stages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | (gpu_culling ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : 0);
+		VkAccessFlags instance_access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | (gpu_culling ? VK_ACCESS_SHADER_READ_BIT : 0);
+		if (!queue_buffer_upload(uploads, instances.data(), sizeof(instance) * instances.size(), instance_usage, instance_stages, instance_access, instance_buffer))
+		{
+			std::cout << "failed to upload instance data!" << std::endl;
+			return -1;
+		}
+		// the acquire goes ahead of every frame on the graphics queue, so the first frame sees the data without a cpu wait
+		if (!flush_uploads(uploads) || !submit_upload_acquires(uploads))
+		{
+			std::cout << "failed to submit startup uploads!" << std::endl;
+			return -1;
+		}
+
+		// with more than one instance the instances are split evenly across the draws, otherwise every draw repeats the triangle
+		u32 instances_per_draw = options.instance_count > 1 ? (options.instance_count + options.draw_count - 1) / options.draw_count : 1;
+		for (u32 i = 0; i < options.draw_count; i++)
+		{
+			draw_command draw{};
+			draw.index_count = index_count;
+			draw.first_index = 0;
+			draw.vertex_offset = 0;
+			draw.first_instance = options.instance_count > 1 ? i * instances_per_draw : 0;
+			if (draw.first_instance >= options.instance_count)
+			{
+				break;
+			}
+			draw.instance_count = std::min(instances_per_draw, options.instance_count - draw.first_instance);
+			draw.depth = instances[draw.first_instance].offset.z;
+			draw.material = material_slots[i % options.material_count];
+			draw_list.push_back(draw);
+		}
+
+		// draws are submitted nearest first as well, independent of where their instances sit in the buffer
+		std::stable_sort(draw_list.begin(), draw_list.end(), [](const draw_command& a, const draw_command& b) { return a.depth < b.depth; });
 
+		// one box per draw that holds every triangle of its instances, and the sphere around it for frustum culling
+		for (const draw_command& draw : draw_list)
+		{
+			glm::vec3 box_min = glm::vec3(1e30f);
+			glm::vec3 box_max = glm::vec3(-1e30f);
+			for (u32 i = draw.first_instance; i < draw.first_instance + draw.instance_count; i++)
+			{
+				glm::vec3 extent = { instances[i].scale * triangle_radius, instances[i].scale * triangle_radius, 0.0f };
+				box_min = glm::min(box_min, instances[i].offset - extent);
+				box_max = glm::max(box_max, instances[i].offset + extent);
+			}
+			add_cull_bounds(draw_bounds, (box_min + box_max) * 0.5f, glm::length(box_max - box_min) * 0.5f);
+			draw_boxes.push_back({ box_min, box_max });
+		}
 
+		if (options.occlusion_cull)
+		{
+			occluder_instances = std::move(instances);
+		}
+	}
 
+	u64 triangles_per_frame = 0;
+	for (const draw_command& draw : draw_list)
+	{
+		triangles_per_frame += (u64)(draw.index_count / 3) * draw.instance_count;
+	}
 
+	std::cout << "GEOMETRY SUCCESSFULLY UPLOADED: " << triangle_vertices.size() << " vertices, " << index_count << " indices, "
+		<< options.instance_count << " instances in " << draw_list.size() << " draws (" << triangles_per_frame << " triangles per frame)" << std::endl;
+	// orthographic camera looking down the depth axis at the instance grid, zooming in pushes part of the
+	// grid off screen. the animation advances per frame rather than per second so benchmark runs repeat exactly,
+	// and static scenes keep the first camera because their command buffers are only recorded once
+	bool animate_camera = options.animate_camera && !options.static_scene;
+	auto get_view_projection = [&](u64 frame) -> glm::mat4
+	{
+		glm::vec2 center = { 0.0f, 0.0f };
+		if (animate_camera)
+		{
+			float angle = frame * 0.01f;
+			center = { 0.5f * std::cos(angle), 0.5f * std::sin(angle) };
+		}
 
+		glm::mat4 view_projection(1.0f);
+		view_projection[0][0] = options.camera_zoom;
+		view_projection[1][1] = options.camera_zoom;
+		view_projection[3][0] = -center.x * options.camera_zoom;
+		view_projection[3][1] = -center.y * options.camera_zoom;
+		return view_projection;
+	};
 
-	while (!glfwWindowShouldClose(window))
+	// culling runs before recording, so draws it rejects never reach a command buffer
+	glm::mat4 view_projection;
+	std::vector<u32> visible_draw_indices;
+	std::vector<draw_command> visible_draws;
+	occlusion_buffer occlusion;
+	if (options.occlusion_cull)
 	{
-		process_input(window);
+		create_occlusion_buffer(occlusion, occlusion_buffer_width, occlusion_buffer_height);
+	}
+	u64 cull_count = 0;
+	u64 frustum_visible_total = 0;
+	u64 visible_draw_total = 0;
+	u64 visible_triangles = 0;
 
-		vkWaitForFences(device, 1, &in_flight_fence, VK_TRUE, UINT64_MAX);
+	auto count_visible_draws = [&]()
+	{
+		visible_draw_total += visible_draws.size();
+		visible_triangles = 0;
+		for (const draw_command& draw : visible_draws)
+		{
+			visible_triangles += (u64)(draw.index_count / 3) * draw.instance_count;
+		}
+	};
 
-		vkResetFences(device, 1, &in_flight_fence);
+	auto cull_draws = [&](u64 frame)
+	{
+		view_projection = get_view_projection(frame);
+		if (gpu_culling)
+		{
+			return;
+		}
 
-		u32 image_index;
-		vkAcquireNextImageKHR(device, swap_chain, UINT64_MAX, image_available_semaphore, VK_NULL_HANDLE, &image_index);
+		cull_frustum(draw_bounds, extract_frustum(view_projection), visible_draw_indices);
+		visible_draws.clear();
+		cull_count++;
+		frustum_visible_total += visible_draw_indices.size();
 
-		vkResetCommandBuffer(command_buffer, 0);
+		if (!options.occlusion_cull)
+		{
+			for (u32 draw_index : visible_draw_indices)
+			{
+				visible_draws.push_back(draw_list[draw_index]);
+			}
+			count_visible_draws();
+			return;
+		}
 
-		//@recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
-		VkCommandBufferBeginInfo command_buffer_begin_specification{};
-		command_buffer_begin_specification.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		command_buffer_begin_specification.flags = 0;
-		command_buffer_begin_specification.pInheritanceInfo = nullptr;
+		// draws are sorted front to back, so each surviving draw occludes the ones after it
+		clear_occlusion_buffer(occlusion);
+		u32 occluder_budget = max_occluder_triangles;
+		for (u32 draw_index : visible_draw_indices)
+		{
+			if (is_occluded(occlusion, view_projection, draw_boxes[draw_index]))
+			{
+				continue;
+			}
 
-		if (vkBeginCommandBuffer(command_buffer, &command_buffer_begin_specification) != VK_SUCCESS)
+			const draw_command& draw = draw_list[draw_index];
+			visible_draws.push_back(draw);
+			for (u32 i = draw.first_instance; i < draw.first_instance + draw.instance_count && occluder_budget > 0; i++)
+			{
+				const instance& occluder = occluder_instances[i];
+				for (u32 index = draw.first_index; index + 2 < draw.first_index + draw.index_count && occluder_budget > 0; index += 3, occluder_budget--)
+				{
+					glm::vec3 triangle[3];
+					for (u32 corner = 0; corner < 3; corner++)
+					{
+						glm::vec2 position = triangle_vertices[triangle_indices[index + corner] + draw.vertex_offset].position * occluder.scale;
+						triangle[corner] = { position.x + occluder.offset.x, position.y + occluder.offset.y, occluder.offset.z };
+					}
+					rasterize_occluder(occlusion, view_projection, triangle);
+				}
+			}
+		}
+		count_visible_draws();
+	};
+	cull_draws(0);
+
+	// gpu culling compacts the instances that pass the frustum test into a per frame buffer and counts them straight
+	// into an indirect draw, so the cpu records one draw and no per object work however many instances there are
+	struct cull_constants
+	{
+		glm::vec4 planes[6];
+		u32 instance_count;
+		float triangle_radius;
+	};
+
+	VkDescriptorSetLayout cull_descriptor_set_layout = VK_NULL_HANDLE;
+	VkPipelineLayout cull_pipeline_layout = VK_NULL_HANDLE;
+	VkPipeline cull_pipeline = VK_NULL_HANDLE;
+	VkDescriptorPool cull_descriptor_pool = VK_NULL_HANDLE;
+	std::vector<VkDescriptorSet> cull_descriptor_sets;
+	std::vector<gpu_buffer> visible_instance_buffers;
+	std::vector<gpu_buffer> indirect_draw_buffers;
+	std::vector<gpu_buffer> visible_count_buffers;
+	if (gpu_culling)
+	{
+		VkDescriptorSetLayoutBinding cull_bindings[3]{};
+		for (u32 i = 0; i < 3; i++)
 		{
-			std::cout << "failed to begin recording command buffer!" << std::endl;
-			return -1;
+			cull_bindings[i].binding = i;
+			cull_bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			cull_bindings[i].descriptorCount = 1;
+			cull_bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 		}
 
-		VkRenderPassBeginInfo render_pass_begin_specification{};
-		render_pass_begin_specification.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		render_pass_begin_specification.renderPass = render_pass;
-		render_pass_begin_specification.framebuffer = swap_chain_frame_buffers[image_index];
-		render_pass_begin_specification.renderArea.offset = { 0, 0 };
-		render_pass_begin_specification.renderArea.extent = swap_chain_extent;
+		VkDescriptorSetLayoutCreateInfo descriptor_set_layout_specification{};
+		descriptor_set_layout_specification.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		descriptor_set_layout_specification.bindingCount = 3;
+		descriptor_set_layout_specification.pBindings = cull_bindings;
 
-		VkClearValue clear_color = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
-		render_pass_begin_specification.clearValueCount = 1;
-		render_pass_begin_specification.pClearValues = &clear_color;
+		if (vkCreateDescriptorSetLayout(device, &descriptor_set_layout_specification, nullptr, &cull_descriptor_set_layout) != VK_SUCCESS)
+		{
+			std::cout << "failed to create cull descriptor set layout!" << std::endl;
+			return -1;
+		}
 
-		vkCmdBeginRenderPass(command_buffer, &render_pass_begin_specification, VK_SUBPASS_CONTENTS_INLINE);
-		vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline);
+		VkPushConstantRange cull_constants_range{};
+		cull_constants_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		cull_constants_range.offset = 0;
+		cull_constants_range.size = sizeof(cull_constants);
 
-		VkViewport viewport{};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = (float)swap_chain_extent.width;
-		viewport.height = (float)swap_chain_extent.height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-		vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+		VkPipelineLayoutCreateInfo cull_pipeline_layout_specification{};
+		cull_pipeline_layout_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		cull_pipeline_layout_specification.setLayoutCount = 1;
+		cull_pipeline_layout_specification.pSetLayouts = &cull_descriptor_set_layout;
+		cull_pipeline_layout_specification.pushConstantRangeCount = 1;
+		cull_pipeline_layout_specification.pPushConstantRanges = &cull_constants_range;
 
-		VkRect2D scissor{};
-		scissor.offset = { 0, 0 };
-		scissor.extent = swap_chain_extent;
-		vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+		if (vkCreatePipelineLayout(device, &cull_pipeline_layout_specification, nullptr, &cull_pipeline_layout) != VK_SUCCESS)
+		{
+			std::cout << "failed to create cull pipeline layout!" << std::endl;
+			return -1;
+		}
 
-		vkCmdDraw(command_buffer, 3, 1, 0, 0);
-		vkCmdEndRenderPass(command_buffer);
+		VkComputePipelineCreateInfo cull_pipeline_specification{};
+		cull_pipeline_specification.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		cull_pipeline_specification.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		cull_pipeline_specification.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		cull_pipeline_specification.stage.module = cull_shader_module;
+		cull_pipeline_specification.stage.pName = "main";
+		cull_pipeline_specification.layout = cull_pipeline_layout;
 
-		if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+		if (vkCreateComputePipelines(device, pipeline_cache, 1, &cull_pipeline_specification, nullptr, &cull_pipeline) != VK_SUCCESS)
 		{
-			std::cout << "failed to record command buffer!" << std::endl;
+			std::cout << "failed to create cull pipeline!" << std::endl;
 			return -1;
 		}
 
-		VkSubmitInfo submit_specification{};
-		submit_specification.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		VkDescriptorPoolSize cull_pool_size{};
+		cull_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		cull_pool_size.descriptorCount = 3 * options.frames_in_flight;
 
-		VkSemaphore wait_semaphores[] = {image_available_semaphore};
-		VkPipelineStageFlags wait_stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-		submit_specification.waitSemaphoreCount = 1;
-		submit_specification.pWaitSemaphores = wait_semaphores;
-		submit_specification.pWaitDstStageMask = wait_stages;
-		submit_specification.commandBufferCount = 1;
-		submit_specification.pCommandBuffers = &command_buffer;
+		VkDescriptorPoolCreateInfo descriptor_pool_specification{};
+		descriptor_pool_specification.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		descriptor_pool_specification.maxSets = options.frames_in_flight;
+		descriptor_pool_specification.poolSizeCount = 1;
+		descriptor_pool_specification.pPoolSizes = &cull_pool_size;
 
-		VkSemaphore signal_semaphores[] = { render_finished_semaphore };
-		submit_specification.signalSemaphoreCount = 1;
-		submit_specification.pSignalSemaphores = signal_semaphores;
+		if (vkCreateDescriptorPool(device, &descriptor_pool_specification, nullptr, &cull_descriptor_pool) != VK_SUCCESS)
+		{
+			std::cout << "failed to create cull descriptor pool!" << std::endl;
+			return -1;
+		}
+
+		std::vector<VkDescriptorSetLayout> cull_set_layouts(options.frames_in_flight, cull_descriptor_set_layout);
+		VkDescriptorSetAllocateInfo descriptor_set_allocation_specification{};
+		descriptor_set_allocation_specification.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		descriptor_set_allocation_specification.descriptorPool = cull_descriptor_pool;
+		descriptor_set_allocation_specification.descriptorSetCount = options.frames_in_flight;
+		descriptor_set_allocation_specification.pSetLayouts = cull_set_layouts.data();
 
-		if (vkQueueSubmit(graphics_queue, 1, &submit_specification, in_flight_fence) != VK_SUCCESS)
+		cull_descriptor_sets.resize(options.frames_in_flight);
+		if (vkAllocateDescriptorSets(device, &descriptor_set_allocation_specification, cull_descriptor_sets.data()) != VK_SUCCESS)
 		{
-			std::cout << "failed to submit draw command buffer!" << std::endl;
+			std::cout << "failed to allocate cull descriptor sets!" << std::endl;
 			return -1;
 		}
 
-		VkSubpassDependency dependency{};
-		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependency.dstSubpass = 0;
-		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		
-		render_pass_specification.dependencyCount = 1;
-		render_pass_specification.pDependencies = &dependency;
+		// every frame in flight compacts into its own buffer, the previous user of it has retired once its timeline value is reached.
+		// the visible instance count is copied back so the triangles the gpu actually drew can be counted
+		visible_instance_buffers.resize(options.frames_in_flight);
+		indirect_draw_buffers.resize(options.frames_in_flight);
+		visible_count_buffers.resize(options.frames_in_flight);
+		for (u32 i = 0; i < options.frames_in_flight; i++)
+		{
+			if (!create_buffer(device, memory_allocator, sizeof(instance) * options.instance_count, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, {}, visible_instance_buffers[i]) ||
+				!create_buffer(device, memory_allocator, sizeof(VkDrawIndexedIndirectCommand),
+					VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, {}, indirect_draw_buffers[i]) ||
+				!create_buffer(device, memory_allocator, sizeof(u32), VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}, visible_count_buffers[i]))
+			{
+				std::cout << "failed to create gpu culling buffers!" << std::endl;
+				return -1;
+			}
+
+			VkDescriptorBufferInfo buffer_descriptions[3]{};
+			buffer_descriptions[0] = { instance_buffer.buffer, 0, VK_WHOLE_SIZE };
+			buffer_descriptions[1] = { visible_instance_buffers[i].buffer, 0, VK_WHOLE_SIZE };
+			buffer_descriptions[2] = { indirect_draw_buffers[i].buffer, 0, VK_WHOLE_SIZE };
+
+			VkWriteDescriptorSet descriptor_write{};
+			descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptor_write.dstSet = cull_descriptor_sets[i];
+			descriptor_write.dstBinding = 0;
+			descriptor_write.descriptorCount = 3;
+			descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			descriptor_write.pBufferInfo = buffer_descriptions;
+			vkUpdateDescriptorSets(device, 1, &descriptor_write, 0, nullptr);
+		}
 
-		VkPresentInfoKHR present_specification{};
-		present_specification.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-		present_specification.waitSemaphoreCount = 1;
-		present_specification.pWaitSemaphores = signal_semaphores;
+		std::cout << "GPU CULLING SUCCESSFULLY INITIALIZED: one indirect draw for " << options.instance_count << " instances" << std::endl;
+	}
 
-		VkSwapchainKHR swap_chains[] = { swap_chain };
-		present_specification.swapchainCount = 1;
-		present_specification.pSwapchains = swap_chains;
-		present_specification.pImageIndices = &image_index;
-		present_specification.pResults = nullptr;
+	// frame constants and per draw constants are bump allocated from the frame's region of the upload arena, the
+	// extra region at the end belongs to static scenes, whose command buffers are recorded once and must never see
+	// their data or their set reset
+	struct frame_constants
+	{
+		glm::mat4 view_projection;
+	};
 
-		vkQueuePresentKHR(present_queue, &present_specification);
+	// read by shader.vert as a std430 array indexed with the pushed draw index
+	struct draw_data
+	{
+		u32 material_index;
+	};
 
+	u32 static_scene_frame = options.frames_in_flight;
+	VkDeviceSize upload_alignment = std::max(physical_device_properties.limits.minUniformBufferOffsetAlignment,
+		physical_device_properties.limits.minStorageBufferOffsetAlignment);
+	VkDeviceSize upload_region_size = sizeof(frame_constants) + sizeof(draw_data) * std::max(draw_list.size(), (size_t)1) + 2 * upload_alignment;
 
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+	upload_arena frame_uploads;
+	if (!create_upload_arena(device, memory_allocator, options.frames_in_flight + 1, upload_region_size, upload_alignment,
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, frame_uploads))
+	{
+		return -1;
 	}
 
-	if (validation_layers_enabled)
+	VkDescriptorPoolSize frame_set_sizes[2]{};
+	frame_set_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frame_set_sizes[0].descriptorCount = 1;
+	frame_set_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	frame_set_sizes[1].descriptorCount = 1;
+
+	descriptor_allocator frame_descriptors;
+	if (!create_descriptor_allocator(device, options.frames_in_flight + 1, descriptor_sets_per_pool, { frame_set_sizes[0], frame_set_sizes[1] }, frame_descriptors))
 	{
-		auto vkDestroyDebugUtilsMessengerEXT = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(vulkan_instance, "vkDestroyDebugUtilsMessengerEXT");
-		if (vkDestroyDebugUtilsMessengerEXT) {
-			vkDestroyDebugUtilsMessengerEXT(vulkan_instance, debug_messenger, nullptr);
+		return -1;
+	}
+
+	struct frame_binding
+	{
+		VkDescriptorSet set = VK_NULL_HANDLE;
+		u32 dynamic_offsets[2] = {};
+	};
+
+	// called once the frame's timeline value has been reached, everything the previous use of the frame allocated is dropped at once
+	// and this frame's data costs two pointer bumps. gpu culled frames have no draw list and use a single entry
+	auto prepare_frame = [&](u32 frame, frame_binding& binding) -> bool
+	{
+		reset_upload_arena(frame_uploads, frame);
+		reset_descriptor_frame(frame_descriptors, frame);
+
+		size_t draw_data_count = std::max(visible_draws.size(), (size_t)1);
+		arena_allocation constants_allocation;
+		arena_allocation draw_data_allocation;
+		if (!arena_allocate(frame_uploads, sizeof(frame_constants), constants_allocation) ||
+			!arena_allocate(frame_uploads, sizeof(draw_data) * draw_data_count, draw_data_allocation))
+		{
+			return false;
 		}
-		else {
-			std::cout << "vkDestroyDebugUtilsMessengerEXT could not be loaded!" << std::endl;
-			return -1;
+
+		frame_constants* constants = (frame_constants*)constants_allocation.data;
+		constants->view_projection = view_projection;
+
+		draw_data* draws = (draw_data*)draw_data_allocation.data;
+		draws[0].material_index = material_slots[0];
+		for (size_t i = 0; i < visible_draws.size(); i++)
+		{
+			draws[i].material_index = visible_draws[i].material;
 		}
-	}
-	
-	vkDestroySemaphore(device, image_available_semaphore, nullptr);
-	vkDestroySemaphore(device, render_finished_semaphore, nullptr);
-	vkDestroyFence(device, in_flight_fence, nullptr);
 
-	vkDestroyCommandPool(device, command_pool, nullptr);
-	for (auto framebuffer : swap_chain_frame_buffers)
-		vkDestroyFramebuffer(device, framebuffer, nullptr);
-	vkDestroyPipeline(device, graphics_pipeline, nullptr);
-	vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
-	vkDestroyRenderPass(device, render_pass, nullptr);
-	for (auto image_view : swap_chain_image_views)
-		vkDestroyImageView(device, image_view, nullptr);
-	vkDestroySwapchainKHR(device, swap_chain, nullptr);
-	vkDestroyDevice(device, nullptr);
-	vkDestroySurfaceKHR(vulkan_instance, surface, nullptr);
-	vkDestroyInstance(vulkan_instance, nullptr);
+		binding.set = allocate_descriptor_set(frame_descriptors, frame, frame_set_layout);
+		if (binding.set == VK_NULL_HANDLE)
+		{
+			return false;
+		}
+		binding.dynamic_offsets[0] = (u32)constants_allocation.offset;
+		binding.dynamic_offsets[1] = (u32)draw_data_allocation.offset;
+
+		VkDescriptorBufferInfo buffer_descriptions[2]{};
+		buffer_descriptions[0].buffer = frame_uploads.buffer.buffer;
+		buffer_descriptions[0].offset = 0;
+		buffer_descriptions[0].range = sizeof(frame_constants);
+		buffer_descriptions[1].buffer = frame_uploads.buffer.buffer;
+		buffer_descriptions[1].offset = 0;
+		buffer_descriptions[1].range = sizeof(draw_data) * draw_data_count;
+
+		VkWriteDescriptorSet descriptor_writes[2]{};
+		for (u32 i = 0; i < 2; i++)
+		{
+			descriptor_writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptor_writes[i].dstSet = binding.set;
+			descriptor_writes[i].dstBinding = i;
+			descriptor_writes[i].descriptorCount = 1;
+			descriptor_writes[i].descriptorType = frame_set_bindings[i].descriptorType;
+			descriptor_writes[i].pBufferInfo = &buffer_descriptions[i];
+		}
+		vkUpdateDescriptorSets(device, 2, descriptor_writes, 0, nullptr);
+		return true;
+	};
 
-	glfwDestroyWindow(window);
-	glfwTerminate();
+	std::cout << "DESCRIPTORS SUCCESSFULLY INITIALIZED: " << options.material_count << " materials in a " << max_material_count << " slot resource table, descriptor indexing "
+		<< (descriptor_indexing_supported ? "on" : "off") << std::endl;
 
-	return 0;
-}
+	std::cout << "depth format " << depth_format << ", " << options.layers << " layers, depth pre-pass " << (options.depth_prepass ? "on" : "off") << std::endl;
+	print_memory_allocator_stats(memory_allocator);
+
+	// static scene command buffers are recorded per image rather than per frame in flight, so they carry no timestamps
+	frame_timing_log timing_log;
+	create_frame_timing_log(timing_log, options.timing_frames);
+	gpu_timer render_pass_timer;
+	if (!options.static_scene && !create_gpu_timer(device, physical_device, indices.graphics_family, options.frames_in_flight, render_pass_timer))
+	{
+		return -1;
+	}
+
+	std::vector<VkCommandBuffer> command_buffers(options.frames_in_flight);
+
+	VkCommandBufferAllocateInfo command_buffer_allocation_specification{};
+	command_buffer_allocation_specification.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	command_buffer_allocation_specification.commandPool = command_pool;
+	command_buffer_allocation_specification.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	command_buffer_allocation_specification.commandBufferCount = (u32)command_buffers.size();
+
+	if (vkAllocateCommandBuffers(device, &command_buffer_allocation_specification, command_buffers.data()) != VK_SUCCESS)
+	{
+		std::cout << "failed to allocate command buffers!" << std::endl;
+		return -1;
+	}
+
+	// render_finished_semaphores are per swapchain image so one is never re-signaled while a present still waits on it.
+	// acquire and present only take binary semaphores, everything else waits on graphics_timeline values:
+	// image_timeline_values holds the value of the last frame that rendered to each image, 0 when none did.
+	// presents are numbered in queue order and image_present_counts holds the number of the last present of each
+	// image. an image only comes back from acquire once its present stopped waiting, so acquiring it completes
+	// every present up to that number
+	std::vector<VkSemaphore> image_available_semaphores(options.frames_in_flight);
+	std::vector<VkSemaphore> render_finished_semaphores(swap_chain_images.size());
+	std::vector<u64> image_timeline_values(swap_chain_images.size(), 0);
+	std::vector<u64> image_present_counts(swap_chain_images.size(), 0);
+	u64 present_count = 0;
+	u64 completed_present_count = 0;
+
+	VkSemaphoreCreateInfo semaphore_specification{};
+	semaphore_specification.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	for (u32 i = 0; i < options.frames_in_flight; i++)
+	{
+		if (vkCreateSemaphore(device, &semaphore_specification, nullptr, &image_available_semaphores[i]) != VK_SUCCESS)
+		{
+			std::cout << "failed to create frame synchronization objects!" << std::endl;
+			return -1;
+		}
+	}
+	for (size_t i = 0; i < render_finished_semaphores.size(); i++)
+	{
+		if (vkCreateSemaphore(device, &semaphore_specification, nullptr, &render_finished_semaphores[i]) != VK_SUCCESS)
+		{
+			std::cout << "failed to create semaphores!" << std::endl;
+			return -1;
+		}
+	}
+
+	double pipeline_wait_start_time = get_time();
+	if (!graphics_pipeline_compiled.get())
+	{
+		return -1;
+	}
+	std::cout << "waited " << (get_time() - pipeline_wait_start_time) * 1000.0 << " ms for the graphics pipeline" << std::endl;
+
+	// secondary recording gives every worker its own command pool per frame in flight, so a worker resets its
+	// pool without synchronizing with the other workers or with frames the GPU is still executing
+	worker_pool recording_workers;
+	std::vector<std::vector<VkCommandPool>> worker_command_pools(options.frames_in_flight);
+	std::vector<std::vector<VkCommandBuffer>> worker_command_buffers(options.frames_in_flight);
+	if (options.recording_threads > 0)
+	{
+		VkCommandPoolCreateInfo worker_command_pool_specification{};
+		worker_command_pool_specification.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		worker_command_pool_specification.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		worker_command_pool_specification.queueFamilyIndex = indices.graphics_family;
+
+		for (u32 frame = 0; frame < options.frames_in_flight; frame++)
+		{
+			worker_command_pools[frame].resize(options.recording_threads);
+			worker_command_buffers[frame].resize(options.recording_threads);
+			for (u32 worker = 0; worker < options.recording_threads; worker++)
+			{
+				if (vkCreateCommandPool(device, &worker_command_pool_specification, nullptr, &worker_command_pools[frame][worker]) != VK_SUCCESS)
+				{
+					std::cout << "failed to create worker command pool!" << std::endl;
+					return -1;
+				}
+
+				VkCommandBufferAllocateInfo secondary_allocation_specification{};
+				secondary_allocation_specification.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				secondary_allocation_specification.commandPool = worker_command_pools[frame][worker];
+				secondary_allocation_specification.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+				secondary_allocation_specification.commandBufferCount = 1;
+
+				if (vkAllocateCommandBuffers(device, &secondary_allocation_specification, &worker_command_buffers[frame][worker]) != VK_SUCCESS)
+				{
+					std::cout << "failed to allocate secondary command buffers!" << std::endl;
+					return -1;
+				}
+			}
+		}
+
+		start_worker_pool(recording_workers, options.recording_threads);
+		std::cout << "recording with " << options.recording_threads << " worker threads" << std::endl;
+	}
+
+	auto bind_draw_state = [&](VkCommandBuffer command_buffer, VkBuffer instances, const frame_binding& frame)
+	{
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = (float)swap_chain_extent.width;
+		viewport.height = (float)swap_chain_extent.height;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+		VkRect2D scissor{};
+		scissor.offset = { 0, 0 };
+		scissor.extent = swap_chain_extent;
+		vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+		VkBuffer vertex_buffers[] = { vertex_buffer.buffer, instances };
+		VkDeviceSize vertex_buffer_offsets[] = { 0, 0 };
+		vkCmdBindVertexBuffers(command_buffer, 0, 2, vertex_buffers, vertex_buffer_offsets);
+		vkCmdBindIndexBuffer(command_buffer, index_buffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+
+		VkDescriptorSet descriptor_sets[] = { resources.set, frame.set };
+		vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 2, descriptor_sets, 2, frame.dynamic_offsets);
+	};
+
+	auto push_draw_constants = [&](VkCommandBuffer command_buffer, size_t draw_index)
+	{
+		draw_constants constants{};
+		constants.draw_index = (u32)draw_index;
+		vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+	};
+
+	// pipeline and dynamic state are not inherited by secondary command buffers, so every slice binds its own.
+	// with a depth pre-pass each slice lays down its own depth first, across worker slices the color pass of
+	// an earlier slice still runs before the pre-pass of a later one, which costs rejection but not correctness
+	auto record_draws = [&](VkCommandBuffer command_buffer, const frame_binding& frame, size_t first_draw, size_t draw_count)
+	{
+		bind_draw_state(command_buffer, instance_buffer.buffer, frame);
+
+		if (options.depth_prepass)
+		{
+			vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, depth_prepass_pipeline);
+			for (size_t i = first_draw; i < first_draw + draw_count; i++)
+			{
+				const draw_command& draw = visible_draws[i];
+				push_draw_constants(command_buffer, i);
+				vkCmdDrawIndexed(command_buffer, draw.index_count, draw.instance_count, draw.first_index, draw.vertex_offset, draw.first_instance);
+			}
+		}
+
+		vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline);
+		for (size_t i = first_draw; i < first_draw + draw_count; i++)
+		{
+			const draw_command& draw = visible_draws[i];
+			push_draw_constants(command_buffer, i);
+			vkCmdDrawIndexed(command_buffer, draw.index_count, draw.instance_count, draw.first_index, draw.vertex_offset, draw.first_instance);
+		}
+	};
+
+	// the cull dispatch is a graph pass of its own, the graph makes its results visible to the scene pass
+	auto record_gpu_culling = [&](VkCommandBuffer command_buffer, u32 frame)
+	{
+		VkDrawIndexedIndirectCommand indirect_draw{};
+		indirect_draw.indexCount = index_count;
+		indirect_draw.instanceCount = 0;
+		vkCmdUpdateBuffer(command_buffer, indirect_draw_buffers[frame].buffer, 0, sizeof(indirect_draw), &indirect_draw);
+
+		VkMemoryBarrier reset_barrier{};
+		reset_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		reset_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		reset_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &reset_barrier, 0, nullptr, 0, nullptr);
+
+		cull_constants constants{};
+		frustum view_frustum = extract_frustum(view_projection);
+		std::copy(std::begin(view_frustum.planes), std::end(view_frustum.planes), constants.planes);
+		constants.instance_count = options.instance_count;
+		constants.triangle_radius = triangle_radius;
+
+		vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, cull_pipeline);
+		vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, cull_pipeline_layout, 0, 1, &cull_descriptor_sets[frame], 0, nullptr);
+		vkCmdPushConstants(command_buffer, cull_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+
+		u32 workgroup_count = (options.instance_count + cull_workgroup_size - 1) / cull_workgroup_size;
+		u32 workgroup_count_x = std::min(workgroup_count, max_workgroup_count);
+		u32 workgroup_count_y = (workgroup_count + workgroup_count_x - 1) / workgroup_count_x;
+		vkCmdDispatch(command_buffer, workgroup_count_x, workgroup_count_y, 1);
+	};
+
+	// the indirect draw covers every instance at once, so it uses the first draw data entry. option parsing rejects
+	// --gpu-cull with more than one material, so the first material is the only one
+	auto record_indirect_draw = [&](VkCommandBuffer command_buffer, u32 frame, const frame_binding& frame_data)
+	{
+		bind_draw_state(command_buffer, visible_instance_buffers[frame].buffer, frame_data);
+		push_draw_constants(command_buffer, 0);
+
+		if (options.depth_prepass)
+		{
+			vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, depth_prepass_pipeline);
+			vkCmdDrawIndexedIndirect(command_buffer, indirect_draw_buffers[frame].buffer, 0, 1, sizeof(VkDrawIndexedIndirectCommand));
+		}
+
+		vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline);
+		vkCmdDrawIndexedIndirect(command_buffer, indirect_draw_buffers[frame].buffer, 0, 1, sizeof(VkDrawIndexedIndirectCommand));
+	};
+
+	auto record_secondary_command_buffers = [&](u32 frame, u32 image_index, const frame_binding& frame_data) -> bool
+	{
+		std::atomic<bool> recorded = true;
+		size_t draws_per_worker = (visible_draws.size() + options.recording_threads - 1) / options.recording_threads;
+
+		run_on_workers(recording_workers, [&](u32 worker_index)
+		{
+			vkResetCommandPool(device, worker_command_pools[frame][worker_index], 0);
+			VkCommandBuffer secondary_command_buffer = worker_command_buffers[frame][worker_index];
+
+			VkCommandBufferInheritanceRenderingInfo inheritance_rendering_specification{};
+			inheritance_rendering_specification.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+			inheritance_rendering_specification.colorAttachmentCount = 1;
+			inheritance_rendering_specification.pColorAttachmentFormats = &swap_chain_image_format;
+			inheritance_rendering_specification.depthAttachmentFormat = depth_format;
+			inheritance_rendering_specification.rasterizationSamples = msaa_samples;
+
+			VkCommandBufferInheritanceInfo inheritance_specification{};
+			inheritance_specification.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+			if (options.dynamic_rendering)
+			{
+				inheritance_specification.pNext = &inheritance_rendering_specification;
+			}
+			else
+			{
+				inheritance_specification.renderPass = render_pass;
+				inheritance_specification.subpass = 0;
+				inheritance_specification.framebuffer = swap_chain_frame_buffers[image_index];
+			}
+
+			VkCommandBufferBeginInfo secondary_begin_specification{};
+			secondary_begin_specification.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			secondary_begin_specification.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+			secondary_begin_specification.pInheritanceInfo = &inheritance_specification;
+
+			if (vkBeginCommandBuffer(secondary_command_buffer, &secondary_begin_specification) != VK_SUCCESS)
+			{
+				recorded = false;
+				return;
+			}
+
+			size_t first_draw = std::min(worker_index * draws_per_worker, visible_draws.size());
+			size_t last_draw = std::min(first_draw + draws_per_worker, visible_draws.size());
+			record_draws(secondary_command_buffer, frame_data, first_draw, last_draw - first_draw);
+
+			if (vkEndCommandBuffer(secondary_command_buffer) != VK_SUCCESS)
+			{
+				recorded = false;
+			}
+		});
+
+		if (!recorded)
+		{
+			std::cout << "failed to record secondary command buffers!" << std::endl;
+		}
+		return recorded.load();
+	};
+
+	// what the passes of the frame graph record for, record_command_buffer sets it before every execution
+	struct graph_frame_state
+	{
+		u32 image_index = 0;
+		u32 frame = nullval;
+		const frame_binding* frame_data = nullptr;
+		bool secondary_command_buffers = false;
+	};
+	graph_frame_state graph_frame;
+
+	// the graph has already moved both attachments into attachment layouts, so the render pass or the
+	// dynamic rendering scope only clears and draws
+	auto record_scene_pass = [&](VkCommandBuffer command_buffer)
+	{
+		VkClearValue clear_values[2]{};
+		clear_values[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
+		clear_values[1].depthStencil = { 1.0f, 0 };
+
+		if (graph_frame.frame != nullval)
+		{
+			write_gpu_timer_begin(render_pass_timer, command_buffer, graph_frame.frame);
+		}
+
+		if (options.dynamic_rendering)
+		{
+			VkRenderingAttachmentInfo color_attachment_specification{};
+			color_attachment_specification.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+			color_attachment_specification.imageView = swap_chain_image_views[graph_frame.image_index];
+			color_attachment_specification.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			color_attachment_specification.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			color_attachment_specification.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			color_attachment_specification.clearValue = clear_values[0];
+			if (multisampled)
+			{
+				// the samples are averaged into the swap chain image as rendering ends and never stored themselves
+				color_attachment_specification.imageView = get_graph_image_view(frame_graph, graph_msaa_color_target);
+				color_attachment_specification.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				color_attachment_specification.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
+				color_attachment_specification.resolveImageView = swap_chain_image_views[graph_frame.image_index];
+				color_attachment_specification.resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			}
+
+			// depth only lives for the pass, so it is never loaded or stored
+			VkRenderingAttachmentInfo depth_attachment_specification{};
+			depth_attachment_specification.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+			depth_attachment_specification.imageView = get_graph_image_view(frame_graph, graph_depth_target);
+			depth_attachment_specification.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			depth_attachment_specification.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			depth_attachment_specification.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			depth_attachment_specification.clearValue = clear_values[1];
+
+			VkRenderingInfo rendering_specification{};
+			rendering_specification.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+			rendering_specification.flags = graph_frame.secondary_command_buffers ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+			rendering_specification.renderArea.offset = { 0, 0 };
+			rendering_specification.renderArea.extent = swap_chain_extent;
+			rendering_specification.layerCount = 1;
+			rendering_specification.colorAttachmentCount = 1;
+			rendering_specification.pColorAttachments = &color_attachment_specification;
+			rendering_specification.pDepthAttachment = &depth_attachment_specification;
+			vkCmdBeginRendering(command_buffer, &rendering_specification);
+		}
+		else
+		{
+			VkRenderPassBeginInfo render_pass_begin_specification{};
+			render_pass_begin_specification.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			render_pass_begin_specification.renderPass = render_pass;
+			render_pass_begin_specification.framebuffer = swap_chain_frame_buffers[graph_frame.image_index];
+			render_pass_begin_specification.renderArea.offset = { 0, 0 };
+			render_pass_begin_specification.renderArea.extent = swap_chain_extent;
+			render_pass_begin_specification.clearValueCount = 2;
+			render_pass_begin_specification.pClearValues = clear_values;
+			vkCmdBeginRenderPass(command_buffer, &render_pass_begin_specification,
+				graph_frame.secondary_command_buffers ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+		}
+
+		if (graph_frame.secondary_command_buffers)
+		{
+			vkCmdExecuteCommands(command_buffer, (u32)worker_command_buffers[graph_frame.frame].size(), worker_command_buffers[graph_frame.frame].data());
+		}
+		else if (gpu_culling)
+		{
+			record_indirect_draw(command_buffer, graph_frame.frame, *graph_frame.frame_data);
+		}
+		else
+		{
+			record_draws(command_buffer, *graph_frame.frame_data, 0, visible_draws.size());
+		}
+
+		if (options.dynamic_rendering)
+		{
+			vkCmdEndRendering(command_buffer);
+		}
+		else
+		{
+			vkCmdEndRenderPass(command_buffer);
+		}
+
+		if (graph_frame.frame != nullval)
+		{
+			write_gpu_timer_end(render_pass_timer, command_buffer, graph_frame.frame);
+		}
+	};
+
+	// the swap chain image arrives undefined once image_available_semaphore has been waited on at COLOR_ATTACHMENT_OUTPUT and
+	// leaves presentable, or ready for the readback copy when offscreen. the culling buffers start with no pending access,
+	// the frame in flight that owns them waited on the timeline for their last use
+	auto build_frame_graph = [&]() -> bool
+	{
+		create_render_graph(device, memory_allocator, frame_graph);
+
+		graph_resource_state acquired_state{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED };
+		graph_resource_state presented_state = options.headless
+			? graph_resource_state{ VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL }
+			: graph_resource_state{ VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR };
+		graph_color_target = import_graph_image(frame_graph, "swap chain image", VK_IMAGE_ASPECT_COLOR_BIT, acquired_state, presented_state);
+		mark_graph_output(frame_graph, graph_color_target);
+
+		// neither depth nor the multisampled color is ever loaded or stored, so both can stay in tile memory
+		graph_image_description depth_description;
+		depth_description.format = depth_format;
+		depth_description.extent = swap_chain_extent;
+		depth_description.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		depth_description.aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+		depth_description.samples = msaa_samples;
+		depth_description.lazily_allocated = true;
+		if (depth_format == VK_FORMAT_D32_SFLOAT_S8_UINT || depth_format == VK_FORMAT_D24_UNORM_S8_UINT)
+		{
+			depth_description.aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+		}
+		graph_depth_target = add_transient_image(frame_graph, "depth", depth_description);
+
+		if (multisampled)
+		{
+			graph_image_description msaa_color_description;
+			msaa_color_description.format = swap_chain_image_format;
+			msaa_color_description.extent = swap_chain_extent;
+			msaa_color_description.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+			msaa_color_description.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+			msaa_color_description.samples = msaa_samples;
+			msaa_color_description.lazily_allocated = true;
+			graph_msaa_color_target = add_transient_image(frame_graph, "msaa color", msaa_color_description);
+		}
+
+		if (gpu_culling)
+		{
+			graph_visible_instances = import_graph_buffer(frame_graph, "visible instances", {}, {});
+			graph_indirect_draws = import_graph_buffer(frame_graph, "indirect draws", {}, {});
+
+			u32 cull_pass = add_graph_pass(frame_graph, "gpu cull", [&](VkCommandBuffer command_buffer) { record_gpu_culling(command_buffer, graph_frame.frame); });
+			graph_pass_write(frame_graph, cull_pass, graph_indirect_draws, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+			graph_pass_write(frame_graph, cull_pass, graph_visible_instances, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+		}
+
+		u32 scene_pass = add_graph_pass(frame_graph, "scene", record_scene_pass);
+		graph_pass_write(frame_graph, scene_pass, graph_color_target, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+		if (multisampled)
+		{
+			graph_pass_write(frame_graph, scene_pass, graph_msaa_color_target, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+		}
+		graph_pass_write(frame_graph, scene_pass, graph_depth_target, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+		if (gpu_culling)
+		{
+			graph_pass_read(frame_graph, scene_pass, graph_indirect_draws, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+			graph_pass_read(frame_graph, scene_pass, graph_visible_instances, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+
+			// the host reads the count once the frame's timeline value is reached
+			graph_visible_count = import_graph_buffer(frame_graph, "visible count", {}, { VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT });
+			mark_graph_output(frame_graph, graph_visible_count);
+
+			u32 readback_pass = add_graph_pass(frame_graph, "visible count readback", [&](VkCommandBuffer command_buffer)
+			{
+				VkBufferCopy count_region{};
+				count_region.srcOffset = offsetof(VkDrawIndexedIndirectCommand, instanceCount);
+				count_region.size = sizeof(u32);
+				vkCmdCopyBuffer(command_buffer, indirect_draw_buffers[graph_frame.frame].buffer, visible_count_buffers[graph_frame.frame].buffer, 1, &count_region);
+			});
+			graph_pass_read(frame_graph, readback_pass, graph_indirect_draws, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+			graph_pass_write(frame_graph, readback_pass, graph_visible_count, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+		}
+
+		return compile_render_graph(frame_graph);
+	};
+
+	if (!build_frame_graph() || !create_frame_buffers())
+	{
+		return -1;
+	}
+
+	// frame is the frame in flight whose worker pools may be used, or nullval to record everything inline
+	auto record_command_buffer = [&](VkCommandBuffer command_buffer, u32 image_index, u32 frame, const frame_binding& frame_data) -> bool
+	{
+		// static scenes never cull on the gpu, so frame is always valid when gpu_culling is set
+		bool use_secondary_command_buffers = options.recording_threads > 0 && frame != nullval && !gpu_culling;
+		if (use_secondary_command_buffers && !record_secondary_command_buffers(frame, image_index, frame_data))
+		{
+			return false;
+		}
+
+		VkCommandBufferBeginInfo command_buffer_begin_specification{};
+		command_buffer_begin_specification.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		command_buffer_begin_specification.flags = 0;
+		command_buffer_begin_specification.pInheritanceInfo = nullptr;
+
+		if (vkBeginCommandBuffer(command_buffer, &command_buffer_begin_specification) != VK_SUCCESS)
+		{
+			std::cout << "failed to begin recording command buffer!" << std::endl;
+			return false;
+		}
+
+		graph_frame.image_index = image_index;
+		graph_frame.frame = frame;
+		graph_frame.frame_data = &frame_data;
+		graph_frame.secondary_command_buffers = use_secondary_command_buffers;
+		set_graph_image(frame_graph, graph_color_target, swap_chain_images[image_index], swap_chain_image_views[image_index]);
+		if (gpu_culling)
+		{
+			set_graph_buffer(frame_graph, graph_visible_instances, visible_instance_buffers[frame].buffer);
+			set_graph_buffer(frame_graph, graph_indirect_draws, indirect_draw_buffers[frame].buffer);
+			set_graph_buffer(frame_graph, graph_visible_count, visible_count_buffers[frame].buffer);
+		}
+		execute_render_graph(frame_graph, command_buffer);
+
+		if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+		{
+			std::cout << "failed to record command buffer!" << std::endl;
+			return false;
+		}
+
+		return true;
+	};
+
+	// static scenes record one command buffer per framebuffer up front and only re-record the ones marked dirty,
+	// the per-image timeline wait in the loop guarantees a buffer is no longer pending when it is resubmitted
+	std::vector<VkCommandBuffer> static_command_buffers;
+	std::vector<bool> static_command_buffers_dirty;
+	frame_binding static_frame_data;
+	if (options.static_scene)
+	{
+		if (!prepare_frame(static_scene_frame, static_frame_data))
+		{
+			return -1;
+		}
+
+		static_command_buffers.resize(swap_chain_images.size());
+		static_command_buffers_dirty.assign(swap_chain_images.size(), true);
+
+		command_buffer_allocation_specification.commandBufferCount = (u32)static_command_buffers.size();
+		if (vkAllocateCommandBuffers(device, &command_buffer_allocation_specification, static_command_buffers.data()) != VK_SUCCESS)
+		{
+			std::cout << "failed to allocate static scene command buffers!" << std::endl;
+			return -1;
+		}
+
+		for (size_t i = 0; i < static_command_buffers.size(); i++)
+		{
+			if (!record_command_buffer(static_command_buffers[i], (u32)i, nullval, static_frame_data))
+			{
+				return -1;
+			}
+			static_command_buffers_dirty[i] = false;
+		}
+		std::cout << "STATIC SCENE COMMAND BUFFERS SUCCESSFULLY RECORDED: " << static_command_buffers.size() << std::endl;
+	}
+
+	auto mark_static_scene_dirty = [&]()
+	{
+		std::fill(static_command_buffers_dirty.begin(), static_command_buffers_dirty.end(), true);
+	};
+
+	// frame_timeline_values holds the graphics timeline value signaled by the last submission of each frame in flight,
+	// once it is reached everything the frame used can be reused. frame_number only counts frames for timing
+	u64 frame_number = 0;
+	std::vector<u64> frame_timeline_values(options.frames_in_flight, 0);
+
+	// a replaced swap chain stays alive until every frame that could still reference it has retired and every
+	// present queued to it has completed, which lets resizing hand oldSwapchain to the driver without a stall.
+	// the timeline only covers the submissions, the presents still wait on the chain's render finished semaphores.
+	// the old chain's images never come back, so its presents are known complete once an image of a later chain,
+	// presented after them, has been acquired again. at shutdown the device is idle and everything goes
+	struct retired_swap_chain
+	{
+		VkSwapchainKHR swap_chain;
+		std::vector<VkImageView> image_views;
+		std::vector<VkFramebuffer> frame_buffers;
+		std::vector<VkSemaphore> render_finished_semaphores;
+		std::vector<VkCommandBuffer> static_command_buffers;
+		render_graph frame_graph;
+		u64 last_timeline_value;
+		u64 last_present_count;
+	};
+	std::vector<retired_swap_chain> retired_swap_chains;
+
+	auto destroy_retired_swap_chains = [&](bool device_idle)
+	{
+		for (auto it = retired_swap_chains.begin(); it != retired_swap_chains.end();)
+		{
+			if (!device_idle && (!timeline_reached(graphics_timeline, it->last_timeline_value) || completed_present_count < it->last_present_count))
+			{
+				it++;
+				continue;
+			}
+
+			if (!it->static_command_buffers.empty())
+				vkFreeCommandBuffers(device, command_pool, (u32)it->static_command_buffers.size(), it->static_command_buffers.data());
+			for (auto semaphore : it->render_finished_semaphores)
+				vkDestroySemaphore(device, semaphore, nullptr);
+			for (auto framebuffer : it->frame_buffers)
+				vkDestroyFramebuffer(device, framebuffer, nullptr);
+			for (auto image_view : it->image_views)
+				vkDestroyImageView(device, image_view, nullptr);
+			destroy_render_graph(it->frame_graph);
+			vkDestroySwapchainKHR(device, it->swap_chain, nullptr);
+
+			it = retired_swap_chains.erase(it);
+		}
+	};
+
+	// hot reload watches the compiled modules, rebuilds the pipeline on a background thread and swaps it in
+	// between frames, rendering keeps using the old pipeline until the new one is ready. modules that are no
+	// longer used are evicted together with the pipelines built from them, those are destroyed once the frames
+	// that could still bind them have retired. reverting a shader rebuilds through the pipeline cache
+	file_watcher shader_watcher;
+	bool watching_shaders = options.hot_reload && !options.headless && options.benchmark_scenario_name.empty()
+		&& start_file_watcher(shader_watcher, shader_directory);
+	bool shader_reload_pending = false;
+	double shader_change_time = 0.0;
+	u64 shader_file_sizes[2] = {};
+	struct shader_reload
+	{
+		pipeline_state state;
+		bool succeeded;
+	};
+	std::future<shader_reload> reloaded_pipeline;
+
+	struct retired_pipeline
+	{
+		VkPipeline pipeline;
+		u64 last_timeline_value;
+	};
+	std::vector<retired_pipeline> retired_pipelines;
+
+	auto destroy_retired_pipelines = [&](bool device_idle)
+	{
+		for (auto it = retired_pipelines.begin(); it != retired_pipelines.end();)
+		{
+			if (!device_idle && !timeline_reached(graphics_timeline, it->last_timeline_value))
+			{
+				it++;
+				continue;
+			}
+			vkDestroyPipeline(device, it->pipeline, nullptr);
+			it = retired_pipelines.erase(it);
+		}
+	};
+
+	// drops the modules of state that the current pipeline does not use
+	auto evict_shader_modules = [&](const pipeline_state& state)
+	{
+		for (VkShaderModule module : { state.vertex_module, state.fragment_module })
+		{
+			if (module == VK_NULL_HANDLE || module == graphics_pipeline_state.vertex_module || module == graphics_pipeline_state.fragment_module)
+			{
+				continue;
+			}
+
+			std::vector<VkPipeline> evicted;
+			evict_pipelines(pipelines, module, evicted);
+			for (VkPipeline pipeline : evicted)
+			{
+				retired_pipelines.push_back({ pipeline, graphics_timeline.submitted_value });
+			}
+			evict_shader_module(shader_modules, module);
+		}
+	};
+
+	auto update_shader_hot_reload = [&]()
+	{
+		if (poll_file_watcher(shader_watcher))
+		{
+			shader_reload_pending = true;
+			shader_change_time = get_time();
+			shader_file_sizes[0] = get_file_size(vertex_shader_path);
+			shader_file_sizes[1] = get_file_size(fragment_shader_path);
+		}
+
+		if (shader_reload_pending && !reloaded_pipeline.valid() && get_time() - shader_change_time >= shader_reload_delay)
+		{
+			// a file still being written has usually grown since the last poll, so the delay starts over until
+			// both sizes hold still. a writer that stalls for the whole delay is not caught, the header is the
+			// only thing load_shader_module checks
+			u64 vertex_size = get_file_size(vertex_shader_path);
+			u64 fragment_size = get_file_size(fragment_shader_path);
+			if (vertex_size != shader_file_sizes[0] || fragment_size != shader_file_sizes[1])
+			{
+				shader_change_time = get_time();
+				shader_file_sizes[0] = vertex_size;
+				shader_file_sizes[1] = fragment_size;
+				return;
+			}
+
+			shader_reload_pending = false;
+			reloaded_pipeline = std::async(std::launch::async, [&, state = graphics_pipeline_state]() mutable -> shader_reload
+			{
+				state.vertex_module = load_shader_module(shader_modules, vertex_shader_path);
+				state.fragment_module = load_shader_module(shader_modules, fragment_shader_path);
+				VkPipeline pipeline = VK_NULL_HANDLE;
+				bool succeeded = state.vertex_module != VK_NULL_HANDLE && state.fragment_module != VK_NULL_HANDLE && build_graphics_pipeline(state, pipeline) &&
+					(!options.depth_prepass || build_graphics_pipeline(get_depth_prepass_state(state), pipeline));
+				return { state, succeeded };
+			});
+		}
+
+		if (reloaded_pipeline.valid() && reloaded_pipeline.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		{
+			shader_reload reload = reloaded_pipeline.get();
+			if (!reload.succeeded)
+			{
+				evict_shader_modules(reload.state);
+				std::cout << "shader reload failed, keeping the current pipeline" << std::endl;
+				return;
+			}
+			if (reload.state == graphics_pipeline_state)
+			{
+				return;
+			}
+
+			pipeline_state replaced_state = graphics_pipeline_state;
+			graphics_pipeline_state = reload.state;
+			graphics_pipeline = get_pipeline(pipelines, graphics_pipeline_state);
+			if (options.depth_prepass)
+			{
+				depth_prepass_pipeline = get_pipeline(pipelines, get_depth_prepass_state(graphics_pipeline_state));
+			}
+			evict_shader_modules(replaced_state);
+			mark_static_scene_dirty();
+			std::cout << "SHADERS SUCCESSFULLY RELOADED" << std::endl;
+		}
+	};
+
+	auto recreate_swap_chain = [&]() -> bool
+	{
+		int width = 0, height = 0;
+		glfwGetFramebufferSize(window, &width, &height);
+		while (width == 0 || height == 0)
+		{
+			if (glfwWindowShouldClose(window))
+			{
+				return true;
+			}
+			glfwWaitEvents();
+			glfwGetFramebufferSize(window, &width, &height);
+		}
+		framebuffer_resized = false;
+
+		retired_swap_chain retired;
+		retired.swap_chain = swap_chain;
+		retired.image_views.swap(swap_chain_image_views);
+		retired.frame_buffers.swap(swap_chain_frame_buffers);
+		retired.render_finished_semaphores.swap(render_finished_semaphores);
+		retired.static_command_buffers.swap(static_command_buffers);
+		retired.frame_graph = std::move(frame_graph);
+		retired.last_timeline_value = graphics_timeline.submitted_value;
+		retired.last_present_count = present_count;
+		retired_swap_chains.push_back(std::move(retired));
+
+		if (!create_swap_chain(swap_chain) || !build_frame_graph() || !create_frame_buffers())
+		{
+			return false;
+		}
+
+		render_finished_semaphores = std::vector<VkSemaphore>(swap_chain_images.size());
+		for (size_t i = 0; i < render_finished_semaphores.size(); i++)
+		{
+			if (vkCreateSemaphore(device, &semaphore_specification, nullptr, &render_finished_semaphores[i]) != VK_SUCCESS)
+			{
+				std::cout << "failed to create semaphores!" << std::endl;
+				return false;
+			}
+		}
+		image_timeline_values.assign(swap_chain_images.size(), 0);
+		image_present_counts.assign(swap_chain_images.size(), 0);
+
+		if (options.static_scene)
+		{
+			static_command_buffers = std::vector<VkCommandBuffer>(swap_chain_images.size());
+			static_command_buffers_dirty.resize(swap_chain_images.size());
+			mark_static_scene_dirty();
+
+			command_buffer_allocation_specification.commandBufferCount = (u32)static_command_buffers.size();
+			if (vkAllocateCommandBuffers(device, &command_buffer_allocation_specification, static_command_buffers.data()) != VK_SUCCESS)
+			{
+				std::cout << "failed to allocate static scene command buffers!" << std::endl;
+				return false;
+			}
+		}
+
+		std::cout << "swap chain recreated: " << swap_chain_extent.width << "x" << swap_chain_extent.height << ", " << swap_chain_images.size() << " images" << std::endl;
+		return true;
+	};
+
+	// copies an offscreen target into host memory and writes it out as a binary ppm
+	auto save_offscreen_image = [&](u32 image_index, const std::string& path) -> bool
+	{
+		VkDeviceSize image_size = (VkDeviceSize)swap_chain_extent.width * swap_chain_extent.height * 4;
+		gpu_buffer readback_buffer;
+		if (!create_buffer(device, memory_allocator, image_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}, readback_buffer))
+		{
+			std::cout << "failed to create readback buffer!" << std::endl;
+			return false;
+		}
+
+		VkCommandBufferAllocateInfo readback_allocation_specification{};
+		readback_allocation_specification.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		readback_allocation_specification.commandPool = command_pool;
+		readback_allocation_specification.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		readback_allocation_specification.commandBufferCount = 1;
+
+		VkCommandBuffer readback_command_buffer;
+		vkAllocateCommandBuffers(device, &readback_allocation_specification, &readback_command_buffer);
+
+		VkCommandBufferBeginInfo readback_begin_specification{};
+		readback_begin_specification.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		readback_begin_specification.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(readback_command_buffer, &readback_begin_specification);
+
+		VkBufferImageCopy copy_region{};
+		copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copy_region.imageSubresource.layerCount = 1;
+		copy_region.imageExtent = { swap_chain_extent.width, swap_chain_extent.height, 1 };
+		vkCmdCopyImageToBuffer(readback_command_buffer, swap_chain_images[image_index], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback_buffer.buffer, 1, &copy_region);
+
+		// make the copy visible to the host read below
+		VkMemoryBarrier host_read_barrier{};
+		host_read_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		host_read_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		host_read_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(readback_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &host_read_barrier, 0, nullptr, 0, nullptr);
+		vkEndCommandBuffer(readback_command_buffer);
+
+		u64 readback_value = next_timeline_value(graphics_timeline);
+		VkTimelineSemaphoreSubmitInfo readback_timeline_specification{};
+		readback_timeline_specification.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		readback_timeline_specification.signalSemaphoreValueCount = 1;
+		readback_timeline_specification.pSignalSemaphoreValues = &readback_value;
+
+		VkSubmitInfo readback_submit_specification{};
+		readback_submit_specification.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		readback_submit_specification.pNext = &readback_timeline_specification;
+		readback_submit_specification.commandBufferCount = 1;
+		readback_submit_specification.pCommandBuffers = &readback_command_buffer;
+		readback_submit_specification.signalSemaphoreCount = 1;
+		readback_submit_specification.pSignalSemaphores = &graphics_timeline.semaphore;
+
+		// only the readback is waited for, not whatever else the queue still has in flight
+		bool copied = vkQueueSubmit(graphics_queue, 1, &readback_submit_specification, VK_NULL_HANDLE) == VK_SUCCESS && wait_for_timeline(graphics_timeline, readback_value);
+		vkFreeCommandBuffers(device, command_pool, 1, &readback_command_buffer);
+		if (!copied)
+		{
+			std::cout << "failed to copy offscreen image!" << std::endl;
+			destroy_buffer(device, memory_allocator, readback_buffer);
+			return false;
+		}
+
+		std::ofstream image_file(path, std::ios::binary);
+		if (!image_file.is_open())
+		{
+			std::cout << "failed to open " << path << "!" << std::endl;
+			destroy_buffer(device, memory_allocator, readback_buffer);
+			return false;
+		}
+
+		bool bgra = swap_chain_image_format == VK_FORMAT_B8G8R8A8_SRGB || swap_chain_image_format == VK_FORMAT_B8G8R8A8_UNORM;
+		const unsigned char* pixels = (const unsigned char*)readback_buffer.allocation.mapped;
+		std::vector<unsigned char> rgb((size_t)swap_chain_extent.width * swap_chain_extent.height * 3);
+		for (size_t i = 0; i < rgb.size() / 3; i++)
+		{
+			rgb[i * 3 + 0] = pixels[i * 4 + (bgra ? 2 : 0)];
+			rgb[i * 3 + 1] = pixels[i * 4 + 1];
+			rgb[i * 3 + 2] = pixels[i * 4 + (bgra ? 0 : 2)];
+		}
+		image_file << "P6\n" << swap_chain_extent.width << " " << swap_chain_extent.height << "\n255\n";
+		image_file.write((const char*)rgb.data(), rgb.size());
+
+		destroy_buffer(device, memory_allocator, readback_buffer);
+		std::cout << "OFFSCREEN IMAGE SUCCESSFULLY WRITTEN: " << path << std::endl;
+		return true;
+	};
+
+	u32 current_frame = 0;
+	bool first_frame_presented = false;
+	u32 frames_this_second = 0;
+	double second_start_time = get_time();
+	double render_start_time = second_start_time;
+	u64 frames_rendered = 0;
+
+	bool benchmarking = !options.benchmark_scenario_name.empty();
+	benchmark_result benchmark;
+	double benchmark_start_time = render_start_time;
+	double last_frame_end_time = render_start_time;
+	present_interval_stats present_intervals_this_second;
+	present_interval_stats present_intervals;
+
+	// throughput counts the triangles that survived culling. the cpu knows them when it records, gpu culled
+	// frames are counted when their visible instance count is read back after the frame retired
+	u64 drawn_triangle_total = 0;
+	u64 drawn_triangles_this_second = 0;
+	std::vector<bool> visible_count_pending(options.frames_in_flight, false);
+	std::vector<bool> visible_count_measured(options.frames_in_flight, false);
+	auto count_drawn_triangles = [&](u64 triangles, bool measured)
+	{
+		drawn_triangle_total += triangles;
+		drawn_triangles_this_second += triangles;
+		if (measured)
+		{
+			benchmark.triangles_drawn += triangles;
+		}
+	};
+	auto collect_visible_count = [&](u32 frame)
+	{
+		if (!visible_count_pending[frame])
+		{
+			return;
+		}
+		u32 visible_instance_count = *(const u32*)visible_count_buffers[frame].allocation.mapped;
+		count_drawn_triangles((u64)visible_instance_count * (index_count / 3), visible_count_measured[frame]);
+		visible_count_pending[frame] = false;
+	};
+
+	auto keep_rendering = [&]() -> bool
+	{
+		u64 warmup_frames = benchmarking ? options.warmup_frames : 0;
+		if (options.frame_limit != 0 && frames_rendered >= options.frame_limit + warmup_frames)
+		{
+			return false;
+		}
+		if (options.duration > 0.0 && frames_rendered > warmup_frames && get_time() - benchmark_start_time >= options.duration)
+		{
+			return false;
+		}
+		return options.headless || !glfwWindowShouldClose(window);
+	};
+
+	while (keep_rendering())
+	{
+		if (window)
+		{
+			process_input(window);
+		}
+
+		if (watching_shaders)
+		{
+			update_shader_hot_reload();
+		}
+
+		double phase_start_time = get_time();
+		frame_timing& timing = begin_frame_timing(timing_log, frame_number + 1, phase_start_time);
+		auto end_phase = [&](frame_phase phase)
+		{
+			double phase_end_time = get_time();
+			timing.phase_times[(u32)phase] = phase_end_time - phase_start_time;
+			phase_start_time = phase_end_time;
+		};
+
+		if (!wait_for_timeline(graphics_timeline, frame_timeline_values[current_frame]))
+		{
+			return -1;
+		}
+		collect_visible_count(current_frame);
+		destroy_retired_swap_chains(false);
+		destroy_retired_pipelines(false);
+		collect_finished_uploads(uploads);
+		resolve_gpu_timer(device, render_pass_timer, current_frame, timing_log);
+		end_phase(frame_phase::fence_wait);
+
+		if (animate_camera)
+		{
+			cull_draws(frame_number + 1);
+		}
+		end_phase(frame_phase::cull);
+
+		// offscreen targets are owned per frame in flight, so there is nothing to acquire
+		u32 image_index = current_frame;
+		if (!options.headless)
+		{
+			VkResult acquire_result = vkAcquireNextImageKHR(device, swap_chain, UINT64_MAX, image_available_semaphores[current_frame], VK_NULL_HANDLE, &image_index);
+			if (acquire_result == VK_ERROR_OUT_OF_DATE_KHR)
+			{
+				if (!recreate_swap_chain())
+				{
+					return -1;
+				}
+				glfwPollEvents();
+				continue;
+			}
+			else if (acquire_result != VK_SUCCESS && acquire_result != VK_SUBOPTIMAL_KHR)
+			{
+				std::cout << "failed to acquire swap chain image!" << std::endl;
+				return -1;
+			}
+			completed_present_count = std::max(completed_present_count, image_present_counts[image_index]);
+		}
+
+		// the acquired image may still be rendered to by an older frame in flight
+		if (!wait_for_timeline(graphics_timeline, image_timeline_values[image_index]))
+		{
+			return -1;
+		}
+		end_phase(frame_phase::acquire);
+
+		VkCommandBuffer command_buffer;
+		if (options.static_scene)
+		{
+			command_buffer = static_command_buffers[image_index];
+			if (static_command_buffers_dirty[image_index])
+			{
+				vkResetCommandBuffer(command_buffer, 0);
+				if (!record_command_buffer(command_buffer, image_index, nullval, static_frame_data))
+				{
+					return -1;
+				}
+				static_command_buffers_dirty[image_index] = false;
+			}
+		}
+		else
+		{
+			command_buffer = command_buffers[current_frame];
+			vkResetCommandBuffer(command_buffer, 0);
+			frame_binding frame_data;
+			if (!prepare_frame(current_frame, frame_data) || !record_command_buffer(command_buffer, image_index, current_frame, frame_data))
+			{
+				return -1;
+			}
+		}
+
+		end_phase(frame_phase::record);
+
+		// anything queued since the last frame goes out now and is acquired ahead of this frame's submission
+		if (!flush_uploads(uploads) || !submit_upload_acquires(uploads))
+		{
+			return -1;
+		}
+
+		VkSubmitInfo submit_specification{};
+		submit_specification.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+		VkSemaphore wait_semaphores[] = { image_available_semaphores[current_frame] };
+		VkPipelineStageFlags wait_stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		submit_specification.waitSemaphoreCount = options.headless ? 0 : 1;
+		submit_specification.pWaitSemaphores = wait_semaphores;
+		submit_specification.pWaitDstStageMask = wait_stages;
+		submit_specification.commandBufferCount = 1;
+		submit_specification.pCommandBuffers = &command_buffer;
+
+		// the timeline goes first so headless runs can drop the binary semaphore by count alone,
+		// the value of the binary semaphore is ignored
+		u64 frame_value = next_timeline_value(graphics_timeline);
+		VkSemaphore signal_semaphores[] = { graphics_timeline.semaphore, render_finished_semaphores[image_index] };
+		u64 signal_values[] = { frame_value, 0 };
+		submit_specification.signalSemaphoreCount = options.headless ? 1 : 2;
+		submit_specification.pSignalSemaphores = signal_semaphores;
+
+		u64 wait_values[] = { 0 };
+		VkTimelineSemaphoreSubmitInfo timeline_submit_specification{};
+		timeline_submit_specification.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timeline_submit_specification.waitSemaphoreValueCount = submit_specification.waitSemaphoreCount;
+		timeline_submit_specification.pWaitSemaphoreValues = wait_values;
+		timeline_submit_specification.signalSemaphoreValueCount = submit_specification.signalSemaphoreCount;
+		timeline_submit_specification.pSignalSemaphoreValues = signal_values;
+		submit_specification.pNext = &timeline_submit_specification;
+
+		if (vkQueueSubmit(graphics_queue, 1, &submit_specification, VK_NULL_HANDLE) != VK_SUCCESS)
+		{
+			std::cout << "failed to submit draw command buffer!" << std::endl;
+			return -1;
+		}
+		frame_number++;
+		frame_timeline_values[current_frame] = frame_value;
+		image_timeline_values[image_index] = frame_value;
+
+		// frames_rendered is counted after the present, so this frame is measured once warmup has been rendered
+		bool measured_frame = benchmarking && frames_rendered >= options.warmup_frames;
+		if (gpu_culling)
+		{
+			visible_count_pending[current_frame] = true;
+			visible_count_measured[current_frame] = measured_frame;
+		}
+		else
+		{
+			count_drawn_triangles(visible_triangles, measured_frame);
+		}
+		if (!options.static_scene)
+		{
+			mark_gpu_timer_pending(render_pass_timer, current_frame, frame_number);
+		}
+		end_phase(frame_phase::submit);
+
+		if (!options.headless)
+		{
+			VkPresentInfoKHR present_specification{};
+			present_specification.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+			present_specification.waitSemaphoreCount = 1;
+			present_specification.pWaitSemaphores = &render_finished_semaphores[image_index];
+
+			VkSwapchainKHR swap_chains[] = { swap_chain };
+			present_specification.swapchainCount = 1;
+			present_specification.pSwapchains = swap_chains;
+			present_specification.pImageIndices = &image_index;
+			present_specification.pResults = nullptr;
+
+			VkResult present_result = vkQueuePresentKHR(present_queue, &present_specification);
+			image_present_counts[image_index] = ++present_count;
+			if (present_result == VK_ERROR_OUT_OF_DATE_KHR || present_result == VK_SUBOPTIMAL_KHR || framebuffer_resized)
+			{
+				if (!recreate_swap_chain())
+				{
+					return -1;
+				}
+			}
+			else if (present_result != VK_SUCCESS)
+			{
+				std::cout << "failed to present swap chain image!" << std::endl;
+				return -1;
+			}
+
+			double present_time = get_time();
+			present_intervals_this_second.record(present_time);
+			present_intervals.record(present_time);
+		}
+
+		end_phase(frame_phase::present);
+
+		if (!first_frame_presented)
+		{
+			std::cout << "time to first frame: " << (get_time() - startup_time) * 1000.0 << " ms" << std::endl;
+			first_frame_presented = true;
+		}
+
+		current_frame = (current_frame + 1) % options.frames_in_flight;
+
+		frames_this_second++;
+		frames_rendered++;
+		double current_time = get_time();
+
+		// warmup frames are dropped so pipeline compilation and clock ramp-up stay out of the statistics
+		if (benchmarking)
+		{
+			if (frames_rendered > options.warmup_frames)
+			{
+				benchmark.frame_times.push_back(current_time - last_frame_end_time);
+			}
+			else if (frames_rendered == options.warmup_frames)
+			{
+				benchmark_start_time = current_time;
+			}
+			last_frame_end_time = current_time;
+		}
+		if (current_time - second_start_time >= 1.0)
+		{
+			double triangles_per_second = (double)drawn_triangles_this_second / (current_time - second_start_time);
+			if (options.headless)
+			{
+				std::cout << frames_this_second << " fps, " << triangles_per_second / 1000000.0 << " Mtris/s" << std::endl;
+			}
+			else
+			{
+				std::string title = "vulkan - " + std::to_string(frames_this_second) + " fps, "
+					+ std::to_string(triangles_per_second / 1000000.0) + " Mtris/s, present interval avg "
+					+ std::to_string(present_intervals_this_second.average_interval() * 1000.0) + " ms max "
+					+ std::to_string(present_intervals_this_second.max_interval * 1000.0) + " ms ("
+					+ present_mode_name(preferred_present_mode) + ", " + std::to_string(swap_chain_images.size()) + " images, "
+					+ std::to_string(options.frames_in_flight) + " frames in flight)";
+				glfwSetWindowTitle(window, title.c_str());
+			}
+			present_intervals_this_second.reset();
+			frames_this_second = 0;
+			drawn_triangles_this_second = 0;
+			second_start_time = current_time;
+		}
+
+		if (window)
+		{
+			glfwPollEvents();
+		}
+	}
+
+	vkDeviceWaitIdle(device);
+	destroy_retired_swap_chains(true);
+	for (u32 i = 0; i < options.frames_in_flight; i++)
+	{
+		collect_visible_count(i);
+	}
+
+	if (reloaded_pipeline.valid())
+	{
+		reloaded_pipeline.wait();
+	}
+	destroy_retired_pipelines(true);
+	if (watching_shaders)
+	{
+		stop_file_watcher(shader_watcher);
+	}
+
+	stop_worker_pool(recording_workers);
+	for (auto& frame_command_pools : worker_command_pools)
+		for (auto worker_command_pool : frame_command_pools)
+			vkDestroyCommandPool(device, worker_command_pool, nullptr);
+
+	if (!options.headless)
+	{
+		std::cout << "present mode " << present_mode_name(preferred_present_mode) << " (" << present_profile_name(options.present) << "): "
+			<< present_intervals.interval_count << " present intervals, min " << present_intervals.min_interval * 1000.0
+			<< " ms, avg " << present_intervals.average_interval() * 1000.0 << " ms, max " << present_intervals.max_interval * 1000.0 << " ms" << std::endl;
+	}
+
+	double render_time = get_time() - render_start_time;
+	if (render_time > 0.0)
+	{
+		std::cout << frames_rendered << " frames of " << triangles_per_frame << " triangles in " << render_time << " s: "
+			<< frames_rendered / render_time << " fps, " << (double)drawn_triangle_total / render_time << " triangles/s drawn" << std::endl;
+	}
+
+	if (cull_count > 0)
+	{
+		std::cout << "culling: " << draw_list.size() << " draws, on average " << (double)frustum_visible_total / cull_count << " inside the frustum and "
+			<< (double)visible_draw_total / cull_count << " recorded" << std::endl;
+	}
+
+	if (options.headless && !options.output_path.empty() && frames_rendered > 0)
+	{
+		u32 last_image_index = (current_frame + options.frames_in_flight - 1) % options.frames_in_flight;
+		if (!save_offscreen_image(last_image_index, options.output_path))
+		{
+			return -1;
+		}
+	}
+
+	for (u32 i = 0; i < options.frames_in_flight; i++)
+	{
+		resolve_gpu_timer(device, render_pass_timer, i, timing_log);
+	}
+	print_frame_timing_summary(timing_log);
+
+	if (benchmarking)
+	{
+		VkPhysicalDeviceProperties device_properties;
+		vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+
+		benchmark.scenario = options.benchmark_scenario_name;
+		benchmark.device_name = device_properties.deviceName;
+		benchmark.present_mode = options.headless ? "NONE" : present_mode_name(preferred_present_mode);
+		benchmark.headless = options.headless;
+		benchmark.frames_in_flight = options.frames_in_flight;
+		benchmark.instance_count = options.instance_count;
+		benchmark.draw_count = (u32)draw_list.size();
+		benchmark.recording_threads = options.recording_threads;
+		benchmark.layers = options.layers;
+		benchmark.depth_prepass = options.depth_prepass;
+		benchmark.camera_zoom = options.camera_zoom;
+		benchmark.animate_camera = animate_camera;
+		benchmark.occlusion_cull = options.occlusion_cull && !gpu_culling;
+		benchmark.gpu_cull = gpu_culling;
+		benchmark.material_count = options.material_count;
+		benchmark.dynamic_rendering = options.dynamic_rendering;
+		benchmark.msaa_samples = msaa_sample_count;
+		benchmark.warmup_frames = std::min(options.warmup_frames, frames_rendered);
+		benchmark.scene_triangles_per_frame = triangles_per_frame;
+		if (!report_benchmark_result(benchmark, options.benchmark_output_path))
+		{
+			return -1;
+		}
+	}
+	if (!options.timing_output_path.empty())
+	{
+		const std::string& path = options.timing_output_path;
+		bool trace = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+		if (trace ? export_frame_timing_trace(timing_log, path.c_str()) : export_frame_timing_csv(timing_log, path.c_str()))
+		{
+			std::cout << "frame timing written to " << path << std::endl;
+		}
+	}
+
+	save_pipeline_cache(device, pipeline_cache, pipeline_cache_path);
+
+	if (validation_layers_enabled)
+	{
+		auto vkDestroyDebugUtilsMessengerEXT = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(vulkan_instance, "vkDestroyDebugUtilsMessengerEXT");
+		if (vkDestroyDebugUtilsMessengerEXT) {
+			vkDestroyDebugUtilsMessengerEXT(vulkan_instance, debug_messenger, nullptr);
+		}
+		else {
+			std::cout << "vkDestroyDebugUtilsMessengerEXT could not be loaded!" << std::endl;
+			return -1;
+		}
+	}
+	
+	for (u32 i = 0; i < options.frames_in_flight; i++)
+	{
+		vkDestroySemaphore(device, image_available_semaphores[i], nullptr);
+	}
+	print_upload_engine_stats(uploads);
+	destroy_upload_engine(uploads);
+	print_queue_timeline_stats("graphics", graphics_timeline);
+	destroy_queue_timeline(graphics_timeline);
+	if (transfer_queue != graphics_queue)
+	{
+		print_queue_timeline_stats("transfer", transfer_timeline);
+		destroy_queue_timeline(transfer_timeline);
+	}
+	for (auto semaphore : render_finished_semaphores)
+		vkDestroySemaphore(device, semaphore, nullptr);
+	destroy_gpu_timer(device, render_pass_timer);
+
+	for (auto framebuffer : swap_chain_frame_buffers)
+		vkDestroyFramebuffer(device, framebuffer, nullptr);
+	for (auto image_view : swap_chain_image_views)
+		vkDestroyImageView(device, image_view, nullptr);
+	print_render_graph_stats(frame_graph);
+	destroy_render_graph(frame_graph);
+	if (options.headless)
+	{
+		for (size_t i = 0; i < swap_chain_images.size(); i++)
+		{
+			vkDestroyImage(device, swap_chain_images[i], nullptr);
+			free_memory(memory_allocator, offscreen_allocations[i]);
+		}
+	}
+	else
+	{
+		vkDestroySwapchainKHR(device, swap_chain, nullptr);
+	}
+
+	for (u32 i = 0; i < visible_instance_buffers.size(); i++)
+	{
+		destroy_buffer(device, memory_allocator, visible_instance_buffers[i]);
+		destroy_buffer(device, memory_allocator, indirect_draw_buffers[i]);
+		destroy_buffer(device, memory_allocator, visible_count_buffers[i]);
+	}
+	std::cout << "upload arena: " << frame_uploads.high_water << " of " << frame_uploads.region_size << " bytes per frame used at most" << std::endl;
+	destroy_upload_arena(device, memory_allocator, frame_uploads);
+	destroy_buffer(device, memory_allocator, material_buffer);
+	destroy_buffer(device, memory_allocator, index_buffer);
+	destroy_buffer(device, memory_allocator, instance_buffer);
+	destroy_buffer(device, memory_allocator, vertex_buffer);
+	destroy_memory_allocator(memory_allocator);
+
+	vkDestroyCommandPool(device, command_pool, nullptr);
+	print_pipeline_registry_stats(pipelines);
+	destroy_pipeline_registry(pipelines);
+	vkDestroyPipeline(device, cull_pipeline, nullptr);
+	vkDestroyDescriptorPool(device, cull_descriptor_pool, nullptr);
+	vkDestroyPipelineLayout(device, cull_pipeline_layout, nullptr);
+	vkDestroyDescriptorSetLayout(device, cull_descriptor_set_layout, nullptr);
+	vkDestroyPipelineCache(device, pipeline_cache, nullptr);
+	destroy_shader_module_cache(shader_modules);
+	vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
+	destroy_descriptor_allocator(frame_descriptors);
+	vkDestroyDescriptorSetLayout(device, frame_set_layout, nullptr);
+	destroy_resource_table(resources);
+	vkDestroyRenderPass(device, render_pass, nullptr);
+	vkDestroyDevice(device, nullptr);
+	if (surface != VK_NULL_HANDLE)
+	{
+		vkDestroySurfaceKHR(vulkan_instance, surface, nullptr);
+	}
+	vkDestroyInstance(vulkan_instance, nullptr);
+
+	if (window)
+	{
+		glfwDestroyWindow(window);
+		glfwTerminate();
+	}
+
+	return 0;
+}
 
 void process_input(GLFWwindow* window)
 {
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, true);
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+	framebuffer_resized = true;
 }
\ No newline at end of file
@@ -0,0 +1,298 @@
+#include "memoryallocator.h"
+
+#include <iostream>
+#include <algorithm>
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static bool create_memory_block(device_memory_allocator& allocator, u32 memory_type, VkDeviceSize size, bool linear, bool dedicated, u32& block_index)
+{
+	if (allocator.device_allocation_count >= allocator.max_allocation_count)
+	{
+		std::cout << "device memory allocation count limit reached: " << allocator.max_allocation_count << std::endl;
+		return false;
+	}
+
+	VkMemoryAllocateInfo memory_allocation_specification{};
+	memory_allocation_specification.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memory_allocation_specification.allocationSize = size;
+	memory_allocation_specification.memoryTypeIndex = memory_type;
+
+	memory_block block;
+	if (vkAllocateMemory(allocator.device, &memory_allocation_specification, nullptr, &block.memory) != VK_SUCCESS)
+	{
+		return false;
+	}
+	allocator.device_allocation_count++;
+
+	if (allocator.memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		vkMapMemory(allocator.device, block.memory, 0, VK_WHOLE_SIZE, 0, &block.mapped);
+	}
+
+	block.size = size;
+	block.linear = linear;
+	block.dedicated = dedicated;
+	block.free_ranges[0] = size;
+
+	// reuse the slot of a released block so outstanding block indices stay valid
+	std::vector<memory_block>& type_blocks = allocator.blocks[memory_type];
+	for (u32 i = 0; i < type_blocks.size(); i++)
+	{
+		if (type_blocks[i].memory == VK_NULL_HANDLE)
+		{
+			type_blocks[i] = std::move(block);
+			block_index = i;
+			return true;
+		}
+	}
+	type_blocks.push_back(std::move(block));
+	block_index = (u32)type_blocks.size() - 1;
+
+	return true;
+}
+
+static void release_memory_block(device_memory_allocator& allocator, memory_block& block)
+{
+	if (block.mapped)
+	{
+		vkUnmapMemory(allocator.device, block.memory);
+	}
+	vkFreeMemory(allocator.device, block.memory, nullptr);
+	allocator.device_allocation_count--;
+	block = memory_block{};
+}
+
+static bool allocate_from_block(memory_block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+{
+	for (auto it = block.free_ranges.begin(); it != block.free_ranges.end(); it++)
+	{
+		VkDeviceSize range_offset = it->first;
+		VkDeviceSize range_end = it->first + it->second;
+		VkDeviceSize aligned_offset = align_up(range_offset, alignment);
+		if (aligned_offset + size > range_end)
+		{
+			continue;
+		}
+
+		block.free_ranges.erase(it);
+		if (aligned_offset > range_offset)
+		{
+			block.free_ranges[range_offset] = aligned_offset - range_offset;
+		}
+		if (aligned_offset + size < range_end)
+		{
+			block.free_ranges[aligned_offset + size] = range_end - (aligned_offset + size);
+		}
+
+		offset = aligned_offset;
+		return true;
+	}
+
+	return false;
+}
+
+static void return_to_block(memory_block& block, VkDeviceSize offset, VkDeviceSize size)
+{
+	auto inserted = block.free_ranges.emplace(offset, size).first;
+
+	auto next = std::next(inserted);
+	if (next != block.free_ranges.end() && inserted->first + inserted->second == next->first)
+	{
+		inserted->second += next->second;
+		block.free_ranges.erase(next);
+	}
+
+	if (inserted != block.free_ranges.begin())
+	{
+		auto previous = std::prev(inserted);
+		if (previous->first + previous->second == inserted->first)
+		{
+			previous->second += inserted->second;
+			block.free_ranges.erase(inserted);
+		}
+	}
+}
+
+bool create_memory_allocator(VkDevice device, VkPhysicalDevice physical_device, device_memory_allocator& allocator)
+{
+	VkPhysicalDeviceProperties device_properties;
+	vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+
+	allocator.device = device;
+	vkGetPhysicalDeviceMemoryProperties(physical_device, &allocator.memory_properties);
+	allocator.max_allocation_count = device_properties.limits.maxMemoryAllocationCount;
+	allocator.device_allocation_count = 0;
+	allocator.blocks.clear();
+	allocator.blocks.resize(allocator.memory_properties.memoryTypeCount);
+
+	return true;
+}
+
+void destroy_memory_allocator(device_memory_allocator& allocator)
+{
+	std::lock_guard<std::mutex> lock(allocator.mutex);
+
+	for (auto& type_blocks : allocator.blocks)
+	{
+		for (auto& block : type_blocks)
+		{
+			if (block.memory == VK_NULL_HANDLE)
+			{
+				continue;
+			}
+			if (block.allocation_count > 0)
+			{
+				std::cout << "memory block destroyed with " << block.allocation_count << " live allocations!" << std::endl;
+			}
+			release_memory_block(allocator, block);
+		}
+	}
+	allocator.blocks.clear();
+}
+
+bool allocate_memory(device_memory_allocator& allocator, const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+	bool linear, memory_allocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(allocator.mutex);
+
+	VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+
+	for (u32 memory_type = 0; memory_type < allocator.memory_properties.memoryTypeCount; memory_type++)
+	{
+		if (!(requirements.memoryTypeBits & (1 << memory_type)) ||
+			(allocator.memory_properties.memoryTypes[memory_type].propertyFlags & properties) != properties)
+		{
+			continue;
+		}
+
+		std::vector<memory_block>& type_blocks = allocator.blocks[memory_type];
+
+		// cap the block size for small heaps so one block never claims most of the heap
+		u32 heap_index = allocator.memory_properties.memoryTypes[memory_type].heapIndex;
+		VkDeviceSize block_size = std::min(allocator.block_size, allocator.memory_properties.memoryHeaps[heap_index].size / 8);
+
+		u32 block_index = nullval;
+		VkDeviceSize offset = 0;
+		bool dedicated = requirements.size > block_size / 2;
+
+		if (!dedicated)
+		{
+			for (u32 i = 0; i < type_blocks.size(); i++)
+			{
+				memory_block& block = type_blocks[i];
+				if (block.memory == VK_NULL_HANDLE || block.dedicated || block.linear != linear)
+				{
+					continue;
+				}
+				if (block.size - block.used >= requirements.size && allocate_from_block(block, requirements.size, alignment, offset))
+				{
+					block_index = i;
+					break;
+				}
+			}
+		}
+
+		if (block_index == nullval)
+		{
+			VkDeviceSize new_block_size = dedicated ? requirements.size : block_size;
+			if (!create_memory_block(allocator, memory_type, new_block_size, linear, dedicated, block_index))
+			{
+				// the heap behind this type may be exhausted, another type with the same properties can still fit
+				continue;
+			}
+			allocate_from_block(type_blocks[block_index], requirements.size, alignment, offset);
+		}
+
+		memory_block& block = type_blocks[block_index];
+		block.used += requirements.size;
+		block.allocation_count++;
+
+		allocation.memory = block.memory;
+		allocation.offset = offset;
+		allocation.size = requirements.size;
+		allocation.mapped = block.mapped ? (char*)block.mapped + offset : nullptr;
+		allocation.memory_type = memory_type;
+		allocation.block_index = block_index;
+
+		return true;
+	}
+
+	std::cout << "failed to allocate device memory: " << requirements.size << " bytes" << std::endl;
+	return false;
+}
+
+void free_memory(device_memory_allocator& allocator, memory_allocation& allocation)
+{
+	if (allocation.memory == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(allocator.mutex);
+
+	memory_block& block = allocator.blocks[allocation.memory_type][allocation.block_index];
+	return_to_block(block, allocation.offset, allocation.size);
+	block.used -= allocation.size;
+	block.allocation_count--;
+
+	if (block.allocation_count == 0 && block.dedicated)
+	{
+		release_memory_block(allocator, block);
+	}
+
+	allocation = memory_allocation{};
+}
+
+memory_allocator_stats get_memory_allocator_stats(device_memory_allocator& allocator, u32 memory_type)
+{
+	std::lock_guard<std::mutex> lock(allocator.mutex);
+
+	memory_allocator_stats stats;
+	for (u32 i = 0; i < allocator.blocks.size(); i++)
+	{
+		if (memory_type != nullval && i != memory_type)
+		{
+			continue;
+		}
+
+		for (const auto& block : allocator.blocks[i])
+		{
+			if (block.memory == VK_NULL_HANDLE)
+			{
+				continue;
+			}
+
+			stats.block_count++;
+			if (block.dedicated)
+			{
+				stats.dedicated_block_count++;
+			}
+			stats.allocation_count += block.allocation_count;
+			stats.reserved_bytes += block.size;
+			stats.used_bytes += block.used;
+		}
+	}
+
+	return stats;
+}
+
+void print_memory_allocator_stats(device_memory_allocator& allocator)
+{
+	std::cout << "device memory usage:" << std::endl;
+	for (u32 i = 0; i < allocator.memory_properties.memoryTypeCount; i++)
+	{
+		memory_allocator_stats stats = get_memory_allocator_stats(allocator, i);
+		if (stats.block_count == 0)
+		{
+			continue;
+		}
+
+		std::cout << "\tmemory type " << i << " (flags " << allocator.memory_properties.memoryTypes[i].propertyFlags << "): "
+			<< stats.allocation_count << " allocations in " << stats.block_count << " blocks ("
+			<< stats.dedicated_block_count << " dedicated), " << stats.used_bytes << " / " << stats.reserved_bytes << " bytes used" << std::endl;
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "vulkancommon.h"
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+// sub-allocates buffers and images out of large VkDeviceMemory blocks so the number of vkAllocateMemory calls
+// stays far below maxMemoryAllocationCount; host visible blocks are mapped once for their whole lifetime
+struct memory_allocation
+{
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize offset = 0;
+	VkDeviceSize size = 0;
+	void* mapped = nullptr;
+	u32 memory_type = nullval;
+	u32 block_index = nullval;
+};
+
+struct memory_block
+{
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize size = 0;
+	VkDeviceSize used = 0;
+	void* mapped = nullptr;
+	u32 allocation_count = 0;
+	// linear (buffers) and optimal (images) resources never share a block, which keeps them
+	// bufferImageGranularity apart without tracking neighbours
+	bool linear = true;
+	bool dedicated = false;
+	std::map<VkDeviceSize, VkDeviceSize> free_ranges;
+};
+
+struct memory_allocator_stats
+{
+	u32 block_count = 0;
+	u32 dedicated_block_count = 0;
+	u32 allocation_count = 0;
+	VkDeviceSize reserved_bytes = 0;
+	VkDeviceSize used_bytes = 0;
+};
+
+struct device_memory_allocator
+{
+	VkDevice device = VK_NULL_HANDLE;
+	VkPhysicalDeviceMemoryProperties memory_properties{};
+	u32 max_allocation_count = 0;
+	VkDeviceSize block_size = 64ull * 1024 * 1024;
+	u32 device_allocation_count = 0;
+
+	// indexed by memory type, a block index is stable for the lifetime of the allocator
+	std::vector<std::vector<memory_block>> blocks;
+	std::mutex mutex;
+};
+
+bool create_memory_allocator(VkDevice device, VkPhysicalDevice physical_device, device_memory_allocator& allocator);
+void destroy_memory_allocator(device_memory_allocator& allocator);
+
+// linear is true for buffers and linearly tiled images, false for optimally tiled images
+bool allocate_memory(device_memory_allocator& allocator, const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+	bool linear, memory_allocation& allocation);
+void free_memory(device_memory_allocator& allocator, memory_allocation& allocation);
+
+memory_allocator_stats get_memory_allocator_stats(device_memory_allocator& allocator, u32 memory_type = nullval);
+void print_memory_allocator_stats(device_memory_allocator& allocator);
@@ -0,0 +1,152 @@
+#include "pipelinecache.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+static bool pipeline_cache_header_valid(const std::vector<char>& data, const VkPhysicalDeviceProperties& device_properties)
+{
+	VkPipelineCacheHeaderVersionOne header{};
+	if (data.size() < sizeof(header))
+	{
+		std::cout << "pipeline cache file too small, ignoring it" << std::endl;
+		return false;
+	}
+
+	std::memcpy(&header.headerSize, data.data(), sizeof(u32));
+	std::memcpy(&header.headerVersion, data.data() + 4, sizeof(u32));
+	std::memcpy(&header.vendorID, data.data() + 8, sizeof(u32));
+	std::memcpy(&header.deviceID, data.data() + 12, sizeof(u32));
+	std::memcpy(header.pipelineCacheUUID, data.data() + 16, VK_UUID_SIZE);
+
+	if (header.headerSize < sizeof(header) || header.headerSize > data.size())
+	{
+		std::cout << "pipeline cache header size invalid, ignoring it" << std::endl;
+		return false;
+	}
+	if (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+	{
+		std::cout << "pipeline cache header version unsupported, ignoring it" << std::endl;
+		return false;
+	}
+	if (header.vendorID != device_properties.vendorID || header.deviceID != device_properties.deviceID)
+	{
+		std::cout << "pipeline cache was written by a different GPU, ignoring it" << std::endl;
+		return false;
+	}
+	if (std::memcmp(header.pipelineCacheUUID, device_properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+	{
+		std::cout << "pipeline cache was written by a different driver version, ignoring it" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+VkPipelineCache create_pipeline_cache(VkDevice device, VkPhysicalDevice physical_device, const char* path)
+{
+	VkPhysicalDeviceProperties device_properties;
+	vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+
+	std::vector<char> cache_data;
+	std::ifstream cache_file(path, std::ios::ate | std::ios::binary);
+	if (cache_file.is_open())
+	{
+		size_t cache_file_size = (size_t)cache_file.tellg();
+		cache_data.resize(cache_file_size);
+		cache_file.seekg(0);
+		cache_file.read(cache_data.data(), cache_file_size);
+		cache_file.close();
+
+		if (!pipeline_cache_header_valid(cache_data, device_properties))
+		{
+			cache_data.clear();
+		}
+	}
+	else
+	{
+		std::cout << "no pipeline cache found at " << path << ", starting cold" << std::endl;
+	}
+
+	VkPipelineCacheCreateInfo pipeline_cache_specification{};
+	pipeline_cache_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	pipeline_cache_specification.initialDataSize = cache_data.size();
+	pipeline_cache_specification.pInitialData = cache_data.empty() ? nullptr : cache_data.data();
+
+	VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
+	if (vkCreatePipelineCache(device, &pipeline_cache_specification, nullptr, &pipeline_cache) == VK_SUCCESS)
+	{
+		if (!cache_data.empty())
+		{
+			std::cout << "PIPELINE CACHE SUCCESSFULLY LOADED: " << cache_data.size() << " bytes" << std::endl;
+		}
+		return pipeline_cache;
+	}
+
+	if (!cache_data.empty())
+	{
+		std::cout << "driver rejected pipeline cache data, starting cold" << std::endl;
+
+		pipeline_cache_specification.initialDataSize = 0;
+		pipeline_cache_specification.pInitialData = nullptr;
+		if (vkCreatePipelineCache(device, &pipeline_cache_specification, nullptr, &pipeline_cache) == VK_SUCCESS)
+		{
+			return pipeline_cache;
+		}
+	}
+
+	std::cout << "failed to create pipeline cache!" << std::endl;
+	return VK_NULL_HANDLE;
+}
+
+bool save_pipeline_cache(VkDevice device, VkPipelineCache pipeline_cache, const char* path)
+{
+	if (pipeline_cache == VK_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	size_t cache_data_size = 0;
+	if (vkGetPipelineCacheData(device, pipeline_cache, &cache_data_size, nullptr) != VK_SUCCESS || cache_data_size == 0)
+	{
+		std::cout << "failed to query pipeline cache data size!" << std::endl;
+		return false;
+	}
+
+	std::vector<char> cache_data(cache_data_size);
+	if (vkGetPipelineCacheData(device, pipeline_cache, &cache_data_size, cache_data.data()) != VK_SUCCESS)
+	{
+		std::cout << "failed to read pipeline cache data!" << std::endl;
+		return false;
+	}
+
+	// write next to the real file first so an interrupted write never leaves a truncated cache behind
+	std::string temporary_path = std::string(path) + ".tmp";
+	std::ofstream cache_file(temporary_path, std::ios::binary | std::ios::trunc);
+	if (!cache_file.is_open())
+	{
+		std::cout << "failed to open pipeline cache file for writing!" << std::endl;
+		return false;
+	}
+	cache_file.write(cache_data.data(), cache_data_size);
+	cache_file.close();
+	if (!cache_file)
+	{
+		std::cout << "failed to write pipeline cache file!" << std::endl;
+		std::remove(temporary_path.c_str());
+		return false;
+	}
+
+	std::remove(path);
+	if (std::rename(temporary_path.c_str(), path) != 0)
+	{
+		std::cout << "failed to move pipeline cache file into place!" << std::endl;
+		return false;
+	}
+
+	std::cout << "PIPELINE CACHE SUCCESSFULLY SAVED: " << cache_data_size << " bytes" << std::endl;
+	return true;
+}
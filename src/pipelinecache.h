@@ -0,0 +1,9 @@
+#pragma once
+
+#include "vulkancommon.h"
+
+// creates a pipeline cache seeded from the file at path when it was written by this exact device and driver,
+// otherwise falls back to an empty cache; returns VK_NULL_HANDLE only if no cache could be created at all
+VkPipelineCache create_pipeline_cache(VkDevice device, VkPhysicalDevice physical_device, const char* path);
+
+bool save_pipeline_cache(VkDevice device, VkPipelineCache pipeline_cache, const char* path);
@@ -0,0 +1,308 @@
+#include "pipelineregistry.h"
+
+#include <iostream>
+
+bool operator==(const pipeline_state& a, const pipeline_state& b)
+{
+	return a.vertex_module == b.vertex_module
+		&& a.fragment_module == b.fragment_module
+		&& a.render_pass == b.render_pass
+		&& a.subpass == b.subpass
+		&& a.color_format == b.color_format
+		&& a.depth_format == b.depth_format
+		&& a.topology == b.topology
+		&& a.polygon_mode == b.polygon_mode
+		&& a.cull_mode == b.cull_mode
+		&& a.front_face == b.front_face
+		&& a.samples == b.samples
+		&& a.blend_enable == b.blend_enable
+		&& a.color_write_mask == b.color_write_mask
+		&& a.depth_test == b.depth_test
+		&& a.depth_write == b.depth_write
+		&& a.depth_compare == b.depth_compare;
+}
+
+static void hash_combine(u64& hash, u64 value)
+{
+	hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+}
+
+// hashed field by field, struct padding would make a byte hash unstable
+u64 hash_pipeline_state(const pipeline_state& state)
+{
+	u64 hash = 0;
+	hash_combine(hash, (u64)state.vertex_module);
+	hash_combine(hash, (u64)state.fragment_module);
+	hash_combine(hash, (u64)state.render_pass);
+	hash_combine(hash, state.subpass);
+	hash_combine(hash, state.color_format);
+	hash_combine(hash, state.depth_format);
+	hash_combine(hash, state.topology);
+	hash_combine(hash, state.polygon_mode);
+	hash_combine(hash, state.cull_mode);
+	hash_combine(hash, state.front_face);
+	hash_combine(hash, state.samples);
+	hash_combine(hash, state.blend_enable);
+	hash_combine(hash, state.color_write_mask);
+	hash_combine(hash, state.depth_test);
+	hash_combine(hash, state.depth_write);
+	hash_combine(hash, state.depth_compare);
+	return hash;
+}
+
+void create_pipeline_registry(VkDevice device, VkPipelineCache pipeline_cache, VkPipelineLayout pipeline_layout,
+	const std::vector<VkVertexInputBindingDescription>& vertex_bindings, const std::vector<VkVertexInputAttributeDescription>& vertex_attributes,
+	pipeline_registry& registry)
+{
+	registry.device = device;
+	registry.pipeline_cache = pipeline_cache;
+	registry.pipeline_layout = pipeline_layout;
+	registry.vertex_bindings = vertex_bindings;
+	registry.vertex_attributes = vertex_attributes;
+	registry.pipelines.clear();
+	registry.base_pipeline = VK_NULL_HANDLE;
+	registry.hit_count = 0;
+	registry.miss_count = 0;
+}
+
+void destroy_pipeline_registry(pipeline_registry& registry)
+{
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for (auto& bucket : registry.pipelines)
+	{
+		for (auto& entry : bucket.second)
+		{
+			vkDestroyPipeline(registry.device, entry.second, nullptr);
+		}
+	}
+	registry.pipelines.clear();
+	registry.base_pipeline = VK_NULL_HANDLE;
+}
+
+static VkPipeline find_pipeline(pipeline_registry& registry, u64 hash, const pipeline_state& state)
+{
+	auto bucket = registry.pipelines.find(hash);
+	if (bucket == registry.pipelines.end())
+	{
+		return VK_NULL_HANDLE;
+	}
+	for (auto& entry : bucket->second)
+	{
+		if (entry.first == state)
+		{
+			return entry.second;
+		}
+	}
+	return VK_NULL_HANDLE;
+}
+
+static VkPipeline build_pipeline(pipeline_registry& registry, const pipeline_state& state, VkPipeline base_pipeline)
+{
+	VkPipelineShaderStageCreateInfo shader_stages[2]{};
+	shader_stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shader_stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shader_stages[0].module = state.vertex_module;
+	shader_stages[0].pName = "main";
+	shader_stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shader_stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shader_stages[1].module = state.fragment_module;
+	shader_stages[1].pName = "main";
+
+	VkDynamicState dynamic_states[] = {
+		VK_DYNAMIC_STATE_VIEWPORT,
+		VK_DYNAMIC_STATE_SCISSOR
+	};
+
+	VkPipelineDynamicStateCreateInfo dynamic_state_specification{};
+	dynamic_state_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamic_state_specification.dynamicStateCount = 2;
+	dynamic_state_specification.pDynamicStates = dynamic_states;
+
+	VkPipelineVertexInputStateCreateInfo vertex_input_specification{};
+	vertex_input_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertex_input_specification.vertexBindingDescriptionCount = (u32)registry.vertex_bindings.size();
+	vertex_input_specification.pVertexBindingDescriptions = registry.vertex_bindings.data();
+	vertex_input_specification.vertexAttributeDescriptionCount = (u32)registry.vertex_attributes.size();
+	vertex_input_specification.pVertexAttributeDescriptions = registry.vertex_attributes.data();
+
+	VkPipelineInputAssemblyStateCreateInfo input_assembly_specification{};
+	input_assembly_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	input_assembly_specification.topology = state.topology;
+	input_assembly_specification.primitiveRestartEnable = VK_FALSE;
+
+	// viewport and scissor are dynamic, only their counts are baked in
+	VkPipelineViewportStateCreateInfo viewport_state_specification{};
+	viewport_state_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewport_state_specification.viewportCount = 1;
+	viewport_state_specification.scissorCount = 1;
+
+	VkPipelineRasterizationStateCreateInfo rasterizer{};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizer.depthClampEnable = VK_FALSE;
+	rasterizer.rasterizerDiscardEnable = VK_FALSE;
+	rasterizer.polygonMode = state.polygon_mode;
+	rasterizer.lineWidth = 1.0f;
+	rasterizer.cullMode = state.cull_mode;
+	rasterizer.frontFace = state.front_face;
+	rasterizer.depthBiasEnable = VK_FALSE;
+
+	VkPipelineMultisampleStateCreateInfo multisampling_specification{};
+	multisampling_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling_specification.sampleShadingEnable = VK_FALSE;
+	multisampling_specification.rasterizationSamples = state.samples;
+	multisampling_specification.minSampleShading = 1.0f;
+
+	VkPipelineColorBlendAttachmentState color_blend_attachment_specification{};
+	color_blend_attachment_specification.colorWriteMask = state.color_write_mask;
+	color_blend_attachment_specification.blendEnable = state.blend_enable ? VK_TRUE : VK_FALSE;
+	color_blend_attachment_specification.srcColorBlendFactor = state.blend_enable ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+	color_blend_attachment_specification.dstColorBlendFactor = state.blend_enable ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO;
+	color_blend_attachment_specification.colorBlendOp = VK_BLEND_OP_ADD;
+	color_blend_attachment_specification.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	color_blend_attachment_specification.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	color_blend_attachment_specification.alphaBlendOp = VK_BLEND_OP_ADD;
+
+	VkPipelineDepthStencilStateCreateInfo depth_stencil_specification{};
+	depth_stencil_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depth_stencil_specification.depthTestEnable = state.depth_test ? VK_TRUE : VK_FALSE;
+	depth_stencil_specification.depthWriteEnable = state.depth_write ? VK_TRUE : VK_FALSE;
+	depth_stencil_specification.depthCompareOp = state.depth_compare;
+	depth_stencil_specification.depthBoundsTestEnable = VK_FALSE;
+	depth_stencil_specification.stencilTestEnable = VK_FALSE;
+
+	VkPipelineColorBlendStateCreateInfo color_blend_specification{};
+	color_blend_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	color_blend_specification.logicOpEnable = VK_FALSE;
+	color_blend_specification.logicOp = VK_LOGIC_OP_COPY;
+	color_blend_specification.attachmentCount = 1;
+	color_blend_specification.pAttachments = &color_blend_attachment_specification;
+
+	VkGraphicsPipelineCreateInfo pipeline_specification{};
+	pipeline_specification.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipeline_specification.stageCount = state.fragment_module != VK_NULL_HANDLE ? 2 : 1;
+	pipeline_specification.pStages = shader_stages;
+	pipeline_specification.pVertexInputState = &vertex_input_specification;
+	pipeline_specification.pInputAssemblyState = &input_assembly_specification;
+	pipeline_specification.pViewportState = &viewport_state_specification;
+	pipeline_specification.pRasterizationState = &rasterizer;
+	pipeline_specification.pMultisampleState = &multisampling_specification;
+	pipeline_specification.pDepthStencilState = &depth_stencil_specification;
+	pipeline_specification.pColorBlendState = &color_blend_specification;
+	pipeline_specification.pDynamicState = &dynamic_state_specification;
+	pipeline_specification.layout = registry.pipeline_layout;
+	pipeline_specification.renderPass = state.render_pass;
+	pipeline_specification.subpass = state.subpass;
+
+	VkPipelineRenderingCreateInfo rendering_specification{};
+	rendering_specification.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+	rendering_specification.colorAttachmentCount = 1;
+	rendering_specification.pColorAttachmentFormats = &state.color_format;
+	rendering_specification.depthAttachmentFormat = state.depth_format;
+	if (state.render_pass == VK_NULL_HANDLE)
+	{
+		pipeline_specification.pNext = &rendering_specification;
+	}
+
+	// every pipeline may serve as a base, variants derive from the first one so drivers can share work
+	pipeline_specification.flags = VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
+	pipeline_specification.basePipelineHandle = VK_NULL_HANDLE;
+	pipeline_specification.basePipelineIndex = -1;
+	if (base_pipeline != VK_NULL_HANDLE)
+	{
+		pipeline_specification.flags |= VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+		pipeline_specification.basePipelineHandle = base_pipeline;
+	}
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	if (vkCreateGraphicsPipelines(registry.device, registry.pipeline_cache, 1, &pipeline_specification, nullptr, &pipeline) != VK_SUCCESS)
+	{
+		std::cout << "failed to create graphics pipeline!" << std::endl;
+		return VK_NULL_HANDLE;
+	}
+	return pipeline;
+}
+
+VkPipeline get_pipeline(pipeline_registry& registry, const pipeline_state& state)
+{
+	u64 hash = hash_pipeline_state(state);
+
+	VkPipeline base_pipeline;
+	{
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		VkPipeline cached = find_pipeline(registry, hash, state);
+		if (cached != VK_NULL_HANDLE)
+		{
+			registry.hit_count++;
+			return cached;
+		}
+		registry.miss_count++;
+		base_pipeline = registry.base_pipeline;
+	}
+
+	// built without the lock so lookups from other threads never wait on a compile
+	VkPipeline pipeline = build_pipeline(registry, state, base_pipeline);
+	if (pipeline == VK_NULL_HANDLE)
+	{
+		return VK_NULL_HANDLE;
+	}
+
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	VkPipeline raced = find_pipeline(registry, hash, state);
+	if (raced != VK_NULL_HANDLE)
+	{
+		vkDestroyPipeline(registry.device, pipeline, nullptr);
+		return raced;
+	}
+
+	registry.pipelines[hash].push_back({ state, pipeline });
+	if (registry.base_pipeline == VK_NULL_HANDLE)
+	{
+		registry.base_pipeline = pipeline;
+	}
+	return pipeline;
+}
+
+void evict_pipelines(pipeline_registry& registry, VkShaderModule module, std::vector<VkPipeline>& evicted)
+{
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for (auto bucket = registry.pipelines.begin(); bucket != registry.pipelines.end();)
+	{
+		auto& entries = bucket->second;
+		for (auto entry = entries.begin(); entry != entries.end();)
+		{
+			if (entry->first.vertex_module != module && entry->first.fragment_module != module)
+			{
+				entry++;
+				continue;
+			}
+
+			// the next pipeline built becomes the base, derivatives only need theirs while they are created
+			if (entry->second == registry.base_pipeline)
+			{
+				registry.base_pipeline = VK_NULL_HANDLE;
+			}
+			evicted.push_back(entry->second);
+			entry = entries.erase(entry);
+		}
+
+		if (entries.empty())
+		{
+			bucket = registry.pipelines.erase(bucket);
+		}
+		else
+		{
+			bucket++;
+		}
+	}
+}
+
+void print_pipeline_registry_stats(pipeline_registry& registry)
+{
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	size_t pipeline_count = 0;
+	for (auto& bucket : registry.pipelines)
+	{
+		pipeline_count += bucket.second.size();
+	}
+	std::cout << "pipeline registry: " << pipeline_count << " pipelines, " << registry.hit_count << " hits, " << registry.miss_count << " misses" << std::endl;
+}
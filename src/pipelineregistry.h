@@ -0,0 +1,64 @@
+#pragma once
+
+#include "vulkancommon.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// everything that can differ between graphics pipeline variants, the rest of the create info is shared,
+// a null fragment module builds a vertex only pipeline for depth pre-passes. a null render pass builds a
+// pipeline for dynamic rendering, described by the attachment formats instead
+struct pipeline_state
+{
+	VkShaderModule vertex_module = VK_NULL_HANDLE;
+	VkShaderModule fragment_module = VK_NULL_HANDLE;
+	VkRenderPass render_pass = VK_NULL_HANDLE;
+	u32 subpass = 0;
+	VkFormat color_format = VK_FORMAT_UNDEFINED;
+	VkFormat depth_format = VK_FORMAT_UNDEFINED;
+	VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	VkPolygonMode polygon_mode = VK_POLYGON_MODE_FILL;
+	VkCullModeFlags cull_mode = VK_CULL_MODE_BACK_BIT;
+	VkFrontFace front_face = VK_FRONT_FACE_CLOCKWISE;
+	VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+	bool blend_enable = false;
+	VkColorComponentFlags color_write_mask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	bool depth_test = false;
+	bool depth_write = false;
+	VkCompareOp depth_compare = VK_COMPARE_OP_LESS;
+};
+
+bool operator==(const pipeline_state& a, const pipeline_state& b);
+u64 hash_pipeline_state(const pipeline_state& state);
+
+// owns every pipeline it builds, the first one is the base that later variants derive from
+struct pipeline_registry
+{
+	VkDevice device = VK_NULL_HANDLE;
+	VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
+	VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+	std::vector<VkVertexInputBindingDescription> vertex_bindings;
+	std::vector<VkVertexInputAttributeDescription> vertex_attributes;
+
+	std::mutex mutex;
+	std::unordered_map<u64, std::vector<std::pair<pipeline_state, VkPipeline>>> pipelines;
+	VkPipeline base_pipeline = VK_NULL_HANDLE;
+	u32 hit_count = 0;
+	u32 miss_count = 0;
+};
+
+void create_pipeline_registry(VkDevice device, VkPipelineCache pipeline_cache, VkPipelineLayout pipeline_layout,
+	const std::vector<VkVertexInputBindingDescription>& vertex_bindings, const std::vector<VkVertexInputAttributeDescription>& vertex_attributes,
+	pipeline_registry& registry);
+void destroy_pipeline_registry(pipeline_registry& registry);
+
+// returns the cached pipeline for state or builds it, safe to call from several threads,
+// returns VK_NULL_HANDLE when the build fails
+VkPipeline get_pipeline(pipeline_registry& registry, const pipeline_state& state);
+
+// removes every pipeline built from module and appends it to evicted, the caller destroys them once
+// no submission uses them anymore
+void evict_pipelines(pipeline_registry& registry, VkShaderModule module, std::vector<VkPipeline>& evicted);
+
+void print_pipeline_registry_stats(pipeline_registry& registry);
@@ -0,0 +1,119 @@
+#include "presentpolicy.h"
+
+#include <algorithm>
+
+bool parse_present_profile(const std::string& name, present_profile& profile)
+{
+	if (name == "low-latency")
+		profile = present_profile::low_latency;
+	else if (name == "power-saving")
+		profile = present_profile::power_saving;
+	else if (name == "throughput")
+		profile = present_profile::throughput;
+	else
+		return false;
+
+	return true;
+}
+
+const char* present_profile_name(present_profile profile)
+{
+	switch (profile)
+	{
+	case present_profile::low_latency: return "low-latency";
+	case present_profile::power_saving: return "power-saving";
+	case present_profile::throughput: return "throughput";
+	}
+	return "unknown";
+}
+
+const char* present_mode_name(VkPresentModeKHR present_mode)
+{
+	switch (present_mode)
+	{
+	case VK_PRESENT_MODE_IMMEDIATE_KHR: return "IMMEDIATE";
+	case VK_PRESENT_MODE_MAILBOX_KHR: return "MAILBOX";
+	case VK_PRESENT_MODE_FIFO_KHR: return "FIFO";
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO_RELAXED";
+	default: return "UNKNOWN";
+	}
+}
+
+VkPresentModeKHR select_present_mode(present_profile profile, const std::vector<VkPresentModeKHR>& available_present_modes)
+{
+	std::vector<VkPresentModeKHR> preferred_present_modes;
+	switch (profile)
+	{
+	case present_profile::low_latency:
+		preferred_present_modes = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+		break;
+	case present_profile::power_saving:
+		preferred_present_modes = { VK_PRESENT_MODE_FIFO_KHR };
+		break;
+	case present_profile::throughput:
+		preferred_present_modes = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR };
+		break;
+	}
+
+	for (VkPresentModeKHR preferred_present_mode : preferred_present_modes)
+	{
+		if (std::find(available_present_modes.begin(), available_present_modes.end(), preferred_present_mode) != available_present_modes.end())
+		{
+			return preferred_present_mode;
+		}
+	}
+
+	// FIFO is the only mode every implementation is required to support
+	return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+u32 select_swap_chain_image_count(present_profile profile, VkPresentModeKHR present_mode, const VkSurfaceCapabilitiesKHR& capabilities)
+{
+	u32 image_count = capabilities.minImageCount;
+	switch (profile)
+	{
+	case present_profile::low_latency:
+		// mailbox needs a spare image to replace while one is displayed and one is queued
+		if (present_mode == VK_PRESENT_MODE_MAILBOX_KHR)
+			image_count = capabilities.minImageCount + 1;
+		break;
+	case present_profile::power_saving:
+		break;
+	case present_profile::throughput:
+		image_count = capabilities.minImageCount + 2;
+		break;
+	}
+
+	if (capabilities.maxImageCount > 0 && image_count > capabilities.maxImageCount)
+		image_count = capabilities.maxImageCount;
+
+	return image_count;
+}
+
+void present_interval_stats::record(double present_time)
+{
+	if (last_present_time >= 0.0)
+	{
+		double interval = present_time - last_present_time;
+		if (interval_count == 0 || interval < min_interval)
+			min_interval = interval;
+		if (interval_count == 0 || interval > max_interval)
+			max_interval = interval;
+		total_interval += interval;
+		interval_count++;
+	}
+	last_present_time = present_time;
+}
+
+void present_interval_stats::reset()
+{
+	min_interval = 0.0;
+	max_interval = 0.0;
+	total_interval = 0.0;
+	interval_count = 0;
+}
+
+double present_interval_stats::average_interval() const
+{
+	return interval_count > 0 ? total_interval / interval_count : 0.0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "vulkancommon.h"
+
+#include <string>
+#include <vector>
+
+// low_latency prefers MAILBOX then IMMEDIATE, power_saving always uses FIFO,
+// throughput prefers IMMEDIATE and queues more swapchain images
+enum class present_profile
+{
+	low_latency,
+	power_saving,
+	throughput
+};
+
+bool parse_present_profile(const std::string& name, present_profile& profile);
+const char* present_profile_name(present_profile profile);
+const char* present_mode_name(VkPresentModeKHR present_mode);
+
+VkPresentModeKHR select_present_mode(present_profile profile, const std::vector<VkPresentModeKHR>& available_present_modes);
+u32 select_swap_chain_image_count(present_profile profile, VkPresentModeKHR present_mode, const VkSurfaceCapabilitiesKHR& capabilities);
+
+// cpu-side time between consecutive vkQueuePresentKHR calls, in seconds
+struct present_interval_stats
+{
+	double last_present_time = -1.0;
+	double min_interval = 0.0;
+	double max_interval = 0.0;
+	double total_interval = 0.0;
+	u32 interval_count = 0;
+
+	void record(double present_time);
+	void reset();
+	double average_interval() const;
+};
@@ -0,0 +1,646 @@
+#include "rendergraph.h"
+
+#include <iostream>
+#include <algorithm>
+
+static const VkAccessFlags write_access_mask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+	VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+void create_render_graph(VkDevice device, device_memory_allocator& allocator, render_graph& graph)
+{
+	graph = render_graph{};
+	graph.device = device;
+	graph.allocator = &allocator;
+}
+
+void destroy_render_graph(render_graph& graph)
+{
+	for (graph_resource& resource : graph.resources)
+	{
+		if (!resource.transient)
+		{
+			continue;
+		}
+		if (resource.view != VK_NULL_HANDLE)
+		{
+			vkDestroyImageView(graph.device, resource.view, nullptr);
+		}
+		if (resource.vk_image != VK_NULL_HANDLE)
+		{
+			vkDestroyImage(graph.device, resource.vk_image, nullptr);
+		}
+	}
+	for (graph_memory_slot& slot : graph.memory_slots)
+	{
+		free_memory(*graph.allocator, slot.allocation);
+	}
+	graph.resources.clear();
+	graph.passes.clear();
+	graph.order.clear();
+	graph.memory_slots.clear();
+	graph.compiled = false;
+}
+
+u32 import_graph_image(render_graph& graph, const std::string& name, VkImageAspectFlags aspect, const graph_resource_state& initial_state, const graph_resource_state& final_state)
+{
+	graph_resource resource;
+	resource.name = name;
+	resource.description.aspect = aspect;
+	resource.initial_state = initial_state;
+	resource.final_state = final_state;
+	graph.resources.push_back(resource);
+	return (u32)graph.resources.size() - 1;
+}
+
+u32 import_graph_buffer(render_graph& graph, const std::string& name, const graph_resource_state& initial_state, const graph_resource_state& final_state)
+{
+	graph_resource resource;
+	resource.name = name;
+	resource.image = false;
+	resource.initial_state = initial_state;
+	resource.final_state = final_state;
+	graph.resources.push_back(resource);
+	return (u32)graph.resources.size() - 1;
+}
+
+u32 add_transient_image(render_graph& graph, const std::string& name, const graph_image_description& description)
+{
+	graph_resource resource;
+	resource.name = name;
+	resource.transient = true;
+	resource.description = description;
+	graph.resources.push_back(resource);
+	return (u32)graph.resources.size() - 1;
+}
+
+void mark_graph_output(render_graph& graph, u32 resource)
+{
+	graph.resources[resource].output = true;
+}
+
+u32 add_graph_pass(render_graph& graph, const std::string& name, const std::function<void(VkCommandBuffer)>& record)
+{
+	graph_pass pass;
+	pass.name = name;
+	pass.record = record;
+	graph.passes.push_back(pass);
+	return (u32)graph.passes.size() - 1;
+}
+
+static void add_pass_access(render_graph& graph, u32 pass, u32 resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout, bool write)
+{
+	for (graph_access& existing : graph.passes[pass].accesses)
+	{
+		if (existing.resource == resource)
+		{
+			existing.state.stages |= stages;
+			existing.state.access |= access;
+			existing.write = existing.write || write;
+			return;
+		}
+	}
+
+	graph_access new_access;
+	new_access.resource = resource;
+	new_access.state.stages = stages;
+	new_access.state.access = access;
+	new_access.state.layout = graph.resources[resource].image ? layout : VK_IMAGE_LAYOUT_UNDEFINED;
+	new_access.write = write;
+	graph.passes[pass].accesses.push_back(new_access);
+}
+
+void graph_pass_read(render_graph& graph, u32 pass, u32 resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout)
+{
+	add_pass_access(graph, pass, resource, stages, access, layout, false);
+}
+
+void graph_pass_write(render_graph& graph, u32 pass, u32 resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout)
+{
+	add_pass_access(graph, pass, resource, stages, access, layout, true);
+}
+
+struct pass_dependency
+{
+	u32 pass;
+	// read after write and write after write keep the earlier pass alive, write after read only orders it
+	bool keeps_alive;
+};
+
+// dependencies follow declaration order: a read depends on the last earlier writer, a write on the last
+// earlier writer and every reader since
+static std::vector<std::vector<pass_dependency>> find_pass_dependencies(const render_graph& graph)
+{
+	std::vector<std::vector<pass_dependency>> dependencies(graph.passes.size());
+	for (u32 resource = 0; resource < graph.resources.size(); resource++)
+	{
+		u32 last_writer = nullval;
+		std::vector<u32> readers;
+		for (u32 pass = 0; pass < graph.passes.size(); pass++)
+		{
+			for (const graph_access& access : graph.passes[pass].accesses)
+			{
+				if (access.resource != resource)
+				{
+					continue;
+				}
+
+				if (last_writer != nullval)
+				{
+					dependencies[pass].push_back({ last_writer, true });
+				}
+				if (access.write)
+				{
+					for (u32 reader : readers)
+					{
+						if (reader != pass)
+						{
+							dependencies[pass].push_back({ reader, false });
+						}
+					}
+					readers.clear();
+					last_writer = pass;
+				}
+				else
+				{
+					readers.push_back(pass);
+				}
+			}
+		}
+	}
+	return dependencies;
+}
+
+static void cull_passes(render_graph& graph, const std::vector<std::vector<pass_dependency>>& dependencies)
+{
+	std::vector<bool> needed(graph.passes.size(), false);
+	std::vector<u32> stack;
+	for (u32 resource = 0; resource < graph.resources.size(); resource++)
+	{
+		if (!graph.resources[resource].output)
+		{
+			continue;
+		}
+
+		// the last writer produces what is left in the output, earlier writers only matter if it depends on them
+		for (u32 pass = (u32)graph.passes.size(); pass-- > 0;)
+		{
+			bool writes = std::any_of(graph.passes[pass].accesses.begin(), graph.passes[pass].accesses.end(),
+				[&](const graph_access& access) { return access.resource == resource && access.write; });
+			if (writes)
+			{
+				stack.push_back(pass);
+				break;
+			}
+		}
+	}
+
+	while (!stack.empty())
+	{
+		u32 pass = stack.back();
+		stack.pop_back();
+		if (needed[pass])
+		{
+			continue;
+		}
+		needed[pass] = true;
+		for (const pass_dependency& dependency : dependencies[pass])
+		{
+			if (dependency.keeps_alive)
+			{
+				stack.push_back(dependency.pass);
+			}
+		}
+	}
+
+	for (u32 pass = 0; pass < graph.passes.size(); pass++)
+	{
+		graph.passes[pass].culled = !needed[pass];
+	}
+}
+
+// a topological sort that, among the passes that are ready, prefers one that does not depend on the pass just
+// scheduled, which puts independent work between a producer and its consumer so the barrier has less to wait for
+static void order_passes(render_graph& graph, const std::vector<std::vector<pass_dependency>>& dependencies)
+{
+	std::vector<u32> remaining_dependencies(graph.passes.size(), 0);
+	std::vector<std::vector<u32>> dependents(graph.passes.size());
+	for (u32 pass = 0; pass < graph.passes.size(); pass++)
+	{
+		if (graph.passes[pass].culled)
+		{
+			continue;
+		}
+		for (const pass_dependency& dependency : dependencies[pass])
+		{
+			if (graph.passes[dependency.pass].culled)
+			{
+				continue;
+			}
+			remaining_dependencies[pass]++;
+			dependents[dependency.pass].push_back(pass);
+		}
+	}
+
+	std::vector<u32> ready;
+	for (u32 pass = 0; pass < graph.passes.size(); pass++)
+	{
+		if (!graph.passes[pass].culled && remaining_dependencies[pass] == 0)
+		{
+			ready.push_back(pass);
+		}
+	}
+
+	graph.order.clear();
+	while (!ready.empty())
+	{
+		size_t chosen = 0;
+		if (!graph.order.empty())
+		{
+			u32 previous = graph.order.back();
+			for (size_t i = 0; i < ready.size(); i++)
+			{
+				bool depends_on_previous = std::any_of(dependencies[ready[i]].begin(), dependencies[ready[i]].end(),
+					[&](const pass_dependency& dependency) { return dependency.pass == previous; });
+				if (!depends_on_previous)
+				{
+					chosen = i;
+					break;
+				}
+			}
+		}
+
+		u32 pass = ready[chosen];
+		ready.erase(ready.begin() + chosen);
+		graph.order.push_back(pass);
+		for (u32 dependent : dependents[pass])
+		{
+			if (--remaining_dependencies[dependent] == 0)
+			{
+				// kept sorted so ties go to declaration order
+				ready.insert(std::upper_bound(ready.begin(), ready.end(), dependent), dependent);
+			}
+		}
+	}
+}
+
+static bool lifetimes_overlap(const graph_resource& a, const graph_resource& b)
+{
+	return a.first_use <= b.last_use && b.first_use <= a.last_use;
+}
+
+static bool has_lazily_allocated_type(const device_memory_allocator& allocator, u32 memory_type_bits)
+{
+	for (u32 memory_type = 0; memory_type < allocator.memory_properties.memoryTypeCount; memory_type++)
+	{
+		if ((memory_type_bits & (1 << memory_type)) && (allocator.memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool create_transient_images(render_graph& graph)
+{
+	std::vector<u32> transients;
+	for (u32 resource_index = 0; resource_index < graph.resources.size(); resource_index++)
+	{
+		graph_resource& resource = graph.resources[resource_index];
+		if (!resource.transient || resource.first_use == nullval)
+		{
+			continue;
+		}
+
+		VkImageCreateInfo image_specification{};
+		image_specification.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		image_specification.imageType = VK_IMAGE_TYPE_2D;
+		image_specification.format = resource.description.format;
+		image_specification.extent = { resource.description.extent.width, resource.description.extent.height, 1 };
+		image_specification.mipLevels = 1;
+		image_specification.arrayLayers = 1;
+		image_specification.samples = resource.description.samples;
+		image_specification.tiling = VK_IMAGE_TILING_OPTIMAL;
+		image_specification.usage = resource.description.usage | (resource.description.lazily_allocated ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : 0);
+		image_specification.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		image_specification.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		if (vkCreateImage(graph.device, &image_specification, nullptr, &resource.vk_image) != VK_SUCCESS)
+		{
+			std::cout << "failed to create transient image " << resource.name << "!" << std::endl;
+			return false;
+		}
+		vkGetImageMemoryRequirements(graph.device, resource.vk_image, &resource.memory_requirements);
+		transients.push_back(resource_index);
+	}
+
+	// largest first, each transient goes into the first slot it fits in without overlapping a lifetime already there
+	std::stable_sort(transients.begin(), transients.end(), [&](u32 a, u32 b) { return graph.resources[a].memory_requirements.size > graph.resources[b].memory_requirements.size; });
+	for (u32 resource_index : transients)
+	{
+		graph_resource& resource = graph.resources[resource_index];
+		for (u32 slot_index = 0; slot_index < graph.memory_slots.size() && resource.memory_slot == nullval; slot_index++)
+		{
+			graph_memory_slot& slot = graph.memory_slots[slot_index];
+			bool overlaps = std::any_of(slot.resources.begin(), slot.resources.end(), [&](u32 other) { return lifetimes_overlap(resource, graph.resources[other]); });
+			if (overlaps || slot.lazily_allocated != resource.description.lazily_allocated || (slot.requirements.memoryTypeBits & resource.memory_requirements.memoryTypeBits) == 0)
+			{
+				continue;
+			}
+
+			slot.requirements.size = std::max(slot.requirements.size, resource.memory_requirements.size);
+			slot.requirements.alignment = std::max(slot.requirements.alignment, resource.memory_requirements.alignment);
+			slot.requirements.memoryTypeBits &= resource.memory_requirements.memoryTypeBits;
+			slot.resources.push_back(resource_index);
+			resource.memory_slot = slot_index;
+		}
+
+		if (resource.memory_slot == nullval)
+		{
+			graph_memory_slot slot;
+			slot.requirements = resource.memory_requirements;
+			slot.lazily_allocated = resource.description.lazily_allocated;
+			slot.resources.push_back(resource_index);
+			graph.memory_slots.push_back(slot);
+			resource.memory_slot = (u32)graph.memory_slots.size() - 1;
+		}
+	}
+
+	for (graph_memory_slot& slot : graph.memory_slots)
+	{
+		// desktop devices rarely have a lazily allocated type, the slot then falls back to ordinary device memory
+		VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		if (slot.lazily_allocated && has_lazily_allocated_type(*graph.allocator, slot.requirements.memoryTypeBits))
+		{
+			properties |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+		}
+		else
+		{
+			slot.lazily_allocated = false;
+		}
+
+		if (!allocate_memory(*graph.allocator, slot.requirements, properties, false, slot.allocation))
+		{
+			std::cout << "failed to allocate transient memory!" << std::endl;
+			return false;
+		}
+
+		for (u32 resource_index : slot.resources)
+		{
+			graph_resource& resource = graph.resources[resource_index];
+			if (vkBindImageMemory(graph.device, resource.vk_image, slot.allocation.memory, slot.allocation.offset) != VK_SUCCESS)
+			{
+				std::cout << "failed to bind transient image " << resource.name << "!" << std::endl;
+				return false;
+			}
+
+			VkImageViewCreateInfo image_view_specification{};
+			image_view_specification.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			image_view_specification.image = resource.vk_image;
+			image_view_specification.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			image_view_specification.format = resource.description.format;
+			image_view_specification.subresourceRange.aspectMask = resource.description.aspect;
+			image_view_specification.subresourceRange.baseMipLevel = 0;
+			image_view_specification.subresourceRange.levelCount = 1;
+			image_view_specification.subresourceRange.baseArrayLayer = 0;
+			image_view_specification.subresourceRange.layerCount = 1;
+
+			if (vkCreateImageView(graph.device, &image_view_specification, nullptr, &resource.view) != VK_SUCCESS)
+			{
+				std::cout << "failed to create transient image view " << resource.name << "!" << std::endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// what the graph knows about a resource while walking the passes in order. visible_* is what has already been
+// made visible since the last write, so a read that is already covered needs no barrier
+struct tracked_state
+{
+	VkPipelineStageFlags write_stages = 0;
+	VkAccessFlags write_access = 0;
+	VkPipelineStageFlags read_stages = 0;
+	VkPipelineStageFlags visible_stages = 0;
+	VkAccessFlags visible_access = 0;
+	VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+};
+
+static void transition(graph_barrier_batch& batch, u32 resource, bool image, tracked_state& tracked, const graph_resource_state& state, bool write)
+{
+	bool layout_change = image && state.layout != tracked.layout;
+	if (write || layout_change)
+	{
+		VkPipelineStageFlags source_stages = tracked.write_stages | tracked.read_stages;
+		if (source_stages != 0 || layout_change)
+		{
+			batch.source_stages |= source_stages != 0 ? source_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			batch.destination_stages |= state.stages;
+			batch.barriers.push_back({ resource, tracked.write_access, state.access, tracked.layout, image ? state.layout : VK_IMAGE_LAYOUT_UNDEFINED });
+		}
+
+		// a layout transition is a write of its own, later readers in other stages still have to wait for it
+		tracked.write_stages = state.stages;
+		tracked.write_access = write ? state.access & write_access_mask : 0;
+		tracked.read_stages = write ? 0 : state.stages;
+		tracked.visible_stages = write ? 0 : state.stages;
+		tracked.visible_access = write ? 0 : state.access;
+		tracked.layout = image ? state.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+		return;
+	}
+
+	bool covered = (state.stages & ~tracked.visible_stages) == 0 && (state.access & ~tracked.visible_access) == 0;
+	if (tracked.write_stages != 0 && !covered)
+	{
+		batch.source_stages |= tracked.write_stages;
+		batch.destination_stages |= state.stages;
+		batch.barriers.push_back({ resource, tracked.write_access, state.access, tracked.layout, tracked.layout });
+		tracked.visible_stages |= state.stages;
+		tracked.visible_access |= state.access;
+	}
+	tracked.read_stages |= state.stages;
+}
+
+static void generate_barriers(render_graph& graph)
+{
+	std::vector<tracked_state> tracked(graph.resources.size());
+	for (u32 resource_index = 0; resource_index < graph.resources.size(); resource_index++)
+	{
+		const graph_resource& resource = graph.resources[resource_index];
+		if (!resource.transient)
+		{
+			tracked[resource_index].write_stages = resource.initial_state.stages;
+			tracked[resource_index].write_access = resource.initial_state.access;
+			tracked[resource_index].layout = resource.initial_state.layout;
+			continue;
+		}
+		if (resource.memory_slot == nullval)
+		{
+			continue;
+		}
+
+		// the memory was last used by whichever transient of the slot ran last, in this execution or the
+		// one before, so the first use waits for every stage any of them touches it in
+		for (u32 other : graph.memory_slots[resource.memory_slot].resources)
+		{
+			for (u32 pass : graph.order)
+			{
+				for (const graph_access& access : graph.passes[pass].accesses)
+				{
+					if (access.resource != other)
+					{
+						continue;
+					}
+					tracked[resource_index].write_stages |= access.state.stages;
+					tracked[resource_index].write_access |= access.state.access & write_access_mask;
+				}
+			}
+		}
+	}
+
+	for (u32 pass : graph.order)
+	{
+		graph_pass& current_pass = graph.passes[pass];
+		current_pass.barriers = graph_barrier_batch{};
+		for (const graph_access& access : current_pass.accesses)
+		{
+			transition(current_pass.barriers, access.resource, graph.resources[access.resource].image, tracked[access.resource], access.state, access.write);
+		}
+	}
+
+	graph.final_barriers = graph_barrier_batch{};
+	for (u32 resource_index = 0; resource_index < graph.resources.size(); resource_index++)
+	{
+		const graph_resource& resource = graph.resources[resource_index];
+		if (resource.transient || resource.first_use == nullval || resource.final_state.stages == 0)
+		{
+			continue;
+		}
+		if (resource.image && resource.final_state.layout == VK_IMAGE_LAYOUT_UNDEFINED)
+		{
+			continue;
+		}
+		transition(graph.final_barriers, resource_index, resource.image, tracked[resource_index], resource.final_state, false);
+	}
+}
+
+bool compile_render_graph(render_graph& graph)
+{
+	std::vector<std::vector<pass_dependency>> dependencies = find_pass_dependencies(graph);
+	cull_passes(graph, dependencies);
+	order_passes(graph, dependencies);
+
+	for (u32 position = 0; position < graph.order.size(); position++)
+	{
+		for (const graph_access& access : graph.passes[graph.order[position]].accesses)
+		{
+			graph_resource& resource = graph.resources[access.resource];
+			resource.first_use = std::min(resource.first_use, position);
+			resource.last_use = resource.last_use == nullval ? position : std::max(resource.last_use, position);
+		}
+	}
+
+	if (!create_transient_images(graph))
+	{
+		return false;
+	}
+	generate_barriers(graph);
+	graph.compiled = true;
+	return true;
+}
+
+void set_graph_image(render_graph& graph, u32 resource, VkImage image, VkImageView view)
+{
+	graph.resources[resource].vk_image = image;
+	graph.resources[resource].view = view;
+}
+
+void set_graph_buffer(render_graph& graph, u32 resource, VkBuffer buffer)
+{
+	graph.resources[resource].buffer = buffer;
+}
+
+VkImageView get_graph_image_view(const render_graph& graph, u32 resource)
+{
+	return graph.resources[resource].view;
+}
+
+static void record_barriers(render_graph& graph, VkCommandBuffer command_buffer, const graph_barrier_batch& batch)
+{
+	if (batch.barriers.empty())
+	{
+		return;
+	}
+
+	graph.image_barrier_scratch.clear();
+	graph.buffer_barrier_scratch.clear();
+	for (const graph_barrier& barrier : batch.barriers)
+	{
+		const graph_resource& resource = graph.resources[barrier.resource];
+		if (resource.image)
+		{
+			VkImageMemoryBarrier image_barrier{};
+			image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			image_barrier.srcAccessMask = barrier.source_access;
+			image_barrier.dstAccessMask = barrier.destination_access;
+			image_barrier.oldLayout = barrier.old_layout;
+			image_barrier.newLayout = barrier.new_layout;
+			image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			image_barrier.image = resource.vk_image;
+			image_barrier.subresourceRange = { resource.description.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+			graph.image_barrier_scratch.push_back(image_barrier);
+		}
+		else
+		{
+			VkBufferMemoryBarrier buffer_barrier{};
+			buffer_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			buffer_barrier.srcAccessMask = barrier.source_access;
+			buffer_barrier.dstAccessMask = barrier.destination_access;
+			buffer_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			buffer_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			buffer_barrier.buffer = resource.buffer;
+			buffer_barrier.offset = 0;
+			buffer_barrier.size = VK_WHOLE_SIZE;
+			graph.buffer_barrier_scratch.push_back(buffer_barrier);
+		}
+	}
+
+	vkCmdPipelineBarrier(command_buffer, batch.source_stages, batch.destination_stages, 0, 0, nullptr,
+		(u32)graph.buffer_barrier_scratch.size(), graph.buffer_barrier_scratch.data(), (u32)graph.image_barrier_scratch.size(), graph.image_barrier_scratch.data());
+}
+
+void execute_render_graph(render_graph& graph, VkCommandBuffer command_buffer)
+{
+	for (u32 pass : graph.order)
+	{
+		record_barriers(graph, command_buffer, graph.passes[pass].barriers);
+		graph.passes[pass].record(command_buffer);
+	}
+	record_barriers(graph, command_buffer, graph.final_barriers);
+}
+
+void print_render_graph_stats(const render_graph& graph)
+{
+	size_t barrier_count = graph.final_barriers.barriers.size();
+	for (u32 pass : graph.order)
+	{
+		barrier_count += graph.passes[pass].barriers.barriers.size();
+	}
+
+	VkDeviceSize transient_bytes = 0;
+	VkDeviceSize unaliased_bytes = 0;
+	VkDeviceSize lazy_bytes = 0;
+	for (const graph_memory_slot& slot : graph.memory_slots)
+	{
+		transient_bytes += slot.requirements.size;
+		lazy_bytes += slot.lazily_allocated ? slot.requirements.size : 0;
+		for (u32 resource : slot.resources)
+		{
+			unaliased_bytes += graph.resources[resource].memory_requirements.size;
+		}
+	}
+
+	std::cout << "render graph: " << graph.order.size() << " of " << graph.passes.size() << " passes live, " << barrier_count << " barriers per execution, "
+		<< transient_bytes << " transient bytes (" << unaliased_bytes << " without aliasing, " << lazy_bytes << " lazily allocated)" << std::endl;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "vulkancommon.h"
+#include "memoryallocator.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// a frame described as passes that declare which resources they read and write. compiling the graph drops
+// passes nothing needs, orders the rest, works out every barrier and layout transition between them and
+// creates the transient images, letting transients whose lifetimes do not overlap share memory. the compiled
+// graph is executed into any number of command buffers, imported resources can be rebound between executions
+struct graph_resource_state
+{
+	VkPipelineStageFlags stages = 0;
+	VkAccessFlags access = 0;
+	VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+};
+
+struct graph_image_description
+{
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	VkExtent2D extent{};
+	VkImageUsageFlags usage = 0;
+	VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+	VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+	// for attachments that are never loaded or stored: the image gets TRANSIENT_ATTACHMENT usage and lazily
+	// allocated memory where the device has it, so tilers never back it with real memory
+	bool lazily_allocated = false;
+};
+
+struct graph_resource
+{
+	std::string name;
+	bool image = true;
+	bool transient = false;
+	bool output = false;
+	graph_image_description description;
+	// imported resources are in initial_state when the graph starts and are left in final_state,
+	// an undefined final layout leaves them in whatever state the last pass used
+	graph_resource_state initial_state;
+	graph_resource_state final_state;
+
+	VkImage vk_image = VK_NULL_HANDLE;
+	VkImageView view = VK_NULL_HANDLE;
+	VkBuffer buffer = VK_NULL_HANDLE;
+
+	// filled in by compile_render_graph, positions in the execution order
+	u32 first_use = nullval;
+	u32 last_use = nullval;
+	u32 memory_slot = nullval;
+	VkMemoryRequirements memory_requirements{};
+};
+
+struct graph_access
+{
+	u32 resource = nullval;
+	graph_resource_state state;
+	bool write = false;
+};
+
+struct graph_barrier
+{
+	u32 resource = nullval;
+	VkAccessFlags source_access = 0;
+	VkAccessFlags destination_access = 0;
+	VkImageLayout old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	VkImageLayout new_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+};
+
+// everything recorded with one vkCmdPipelineBarrier
+struct graph_barrier_batch
+{
+	VkPipelineStageFlags source_stages = 0;
+	VkPipelineStageFlags destination_stages = 0;
+	std::vector<graph_barrier> barriers;
+};
+
+struct graph_pass
+{
+	std::string name;
+	std::vector<graph_access> accesses;
+	std::function<void(VkCommandBuffer)> record;
+	bool culled = false;
+	graph_barrier_batch barriers;
+};
+
+// transients placed in one slot share its memory, their lifetimes never overlap
+struct graph_memory_slot
+{
+	VkMemoryRequirements requirements{};
+	bool lazily_allocated = false;
+	std::vector<u32> resources;
+	memory_allocation allocation;
+};
+
+struct render_graph
+{
+	VkDevice device = VK_NULL_HANDLE;
+	device_memory_allocator* allocator = nullptr;
+
+	std::vector<graph_resource> resources;
+	std::vector<graph_pass> passes;
+	// live passes in execution order
+	std::vector<u32> order;
+	std::vector<graph_memory_slot> memory_slots;
+	graph_barrier_batch final_barriers;
+	bool compiled = false;
+
+	std::vector<VkImageMemoryBarrier> image_barrier_scratch;
+	std::vector<VkBufferMemoryBarrier> buffer_barrier_scratch;
+};
+
+void create_render_graph(VkDevice device, device_memory_allocator& allocator, render_graph& graph);
+// the transients may still be in use until every execution of the graph has finished on the gpu
+void destroy_render_graph(render_graph& graph);
+
+u32 import_graph_image(render_graph& graph, const std::string& name, VkImageAspectFlags aspect, const graph_resource_state& initial_state, const graph_resource_state& final_state);
+u32 import_graph_buffer(render_graph& graph, const std::string& name, const graph_resource_state& initial_state, const graph_resource_state& final_state);
+// created by compile_render_graph and only while some live pass uses it, its contents never survive an execution
+u32 add_transient_image(render_graph& graph, const std::string& name, const graph_image_description& description);
+// outputs are what the graph is executed for, a pass survives culling only if an output depends on it
+void mark_graph_output(render_graph& graph, u32 resource);
+
+u32 add_graph_pass(render_graph& graph, const std::string& name, const std::function<void(VkCommandBuffer)>& record);
+// layout only matters for images. a pass may read and write the same resource, the accesses are merged
+void graph_pass_read(render_graph& graph, u32 pass, u32 resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED);
+void graph_pass_write(render_graph& graph, u32 pass, u32 resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED);
+
+bool compile_render_graph(render_graph& graph);
+
+void set_graph_image(render_graph& graph, u32 resource, VkImage image, VkImageView view);
+void set_graph_buffer(render_graph& graph, u32 resource, VkBuffer buffer);
+VkImageView get_graph_image_view(const render_graph& graph, u32 resource);
+
+// records every live pass with the barriers in front of it, imported resources must be bound
+void execute_render_graph(render_graph& graph, VkCommandBuffer command_buffer);
+
+void print_render_graph_stats(const render_graph& graph);
@@ -0,0 +1,212 @@
+#include "shadercache.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <iostream>
+
+const u32 spirv_magic_number = 0x07230203;
+// magic, version, generator, id bound and a reserved zero
+const size_t spirv_header_word_count = 5;
+
+bool map_file(const char* path, mapped_file& file)
+{
+	file = mapped_file{};
+
+#ifdef _WIN32
+	HANDLE file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file_handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0)
+	{
+		CloseHandle(file_handle);
+		return false;
+	}
+
+	HANDLE mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping_handle)
+	{
+		CloseHandle(file_handle);
+		return false;
+	}
+
+	const void* data = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping_handle);
+		CloseHandle(file_handle);
+		return false;
+	}
+
+	file.data = data;
+	file.size = (size_t)file_size.QuadPart;
+	file.file_handle = file_handle;
+	file.mapping_handle = mapping_handle;
+#else
+	int file_descriptor = open(path, O_RDONLY);
+	if (file_descriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat file_status;
+	if (fstat(file_descriptor, &file_status) != 0 || file_status.st_size == 0)
+	{
+		close(file_descriptor);
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)file_status.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	if (data == MAP_FAILED)
+	{
+		close(file_descriptor);
+		return false;
+	}
+
+	file.data = data;
+	file.size = (size_t)file_status.st_size;
+	file.file_descriptor = file_descriptor;
+#endif
+
+	return true;
+}
+
+void unmap_file(mapped_file& file)
+{
+	if (!file.data)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(file.data);
+	CloseHandle(file.mapping_handle);
+	CloseHandle(file.file_handle);
+#else
+	munmap(const_cast<void*>(file.data), file.size);
+	close(file.file_descriptor);
+#endif
+
+	file = mapped_file{};
+}
+
+u64 get_file_size(const char* path)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA file_attributes;
+	if (!GetFileAttributesExA(path, GetFileExInfoStandard, &file_attributes))
+	{
+		return 0;
+	}
+	return ((u64)file_attributes.nFileSizeHigh << 32) | file_attributes.nFileSizeLow;
+#else
+	struct stat file_status;
+	if (stat(path, &file_status) != 0)
+	{
+		return 0;
+	}
+	return (u64)file_status.st_size;
+#endif
+}
+
+void create_shader_module_cache(VkDevice device, shader_module_cache& cache)
+{
+	cache.device = device;
+	cache.modules.clear();
+}
+
+void destroy_shader_module_cache(shader_module_cache& cache)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	for (auto& entry : cache.modules)
+	{
+		vkDestroyShaderModule(cache.device, entry.second, nullptr);
+	}
+	cache.modules.clear();
+}
+
+// 64-bit fnv-1a over the raw module bytes
+u64 hash_shader_code(const void* code, size_t size)
+{
+	u64 hash = 14695981039346656037ull;
+	const unsigned char* bytes = (const unsigned char*)code;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+VkShaderModule load_shader_module(shader_module_cache& cache, const char* path)
+{
+	mapped_file file;
+	if (!map_file(path, file))
+	{
+		std::cout << "failed to map shader file " << path << "!" << std::endl;
+		return VK_NULL_HANDLE;
+	}
+
+	// mappings are page aligned, so the code can be passed to the driver without a copy. only the header is
+	// checked here, a module cut short after a complete header still reaches the driver
+	const u32* words = (const u32*)file.data;
+	if (file.size % 4 != 0 || file.size / 4 < spirv_header_word_count || words[0] != spirv_magic_number || words[3] == 0)
+	{
+		std::cout << path << " is not a spir-v module!" << std::endl;
+		unmap_file(file);
+		return VK_NULL_HANDLE;
+	}
+
+	u64 hash = hash_shader_code(file.data, file.size);
+
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	auto cached = cache.modules.find(hash);
+	if (cached != cache.modules.end())
+	{
+		unmap_file(file);
+		return cached->second;
+	}
+
+	VkShaderModuleCreateInfo shader_module_specification{};
+	shader_module_specification.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	shader_module_specification.codeSize = file.size;
+	shader_module_specification.pCode = (const u32*)file.data;
+
+	VkShaderModule shader_module = VK_NULL_HANDLE;
+	VkResult result = vkCreateShaderModule(cache.device, &shader_module_specification, nullptr, &shader_module);
+	unmap_file(file);
+	if (result != VK_SUCCESS)
+	{
+		std::cout << "failed to create shader module from " << path << "!" << std::endl;
+		return VK_NULL_HANDLE;
+	}
+
+	cache.modules[hash] = shader_module;
+	return shader_module;
+}
+
+void evict_shader_module(shader_module_cache& cache, VkShaderModule module)
+{
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	for (auto it = cache.modules.begin(); it != cache.modules.end(); it++)
+	{
+		if (it->second == module)
+		{
+			vkDestroyShaderModule(cache.device, module, nullptr);
+			cache.modules.erase(it);
+			return;
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "vulkancommon.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// read-only memory mapping of a whole file, MapViewOfFile on windows and mmap elsewhere
+struct mapped_file
+{
+	const void* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* file_handle = nullptr;
+	void* mapping_handle = nullptr;
+#else
+	int file_descriptor = -1;
+#endif
+};
+
+bool map_file(const char* path, mapped_file& file);
+void unmap_file(mapped_file& file);
+
+// 0 when the file does not exist
+u64 get_file_size(const char* path);
+
+// shader modules keyed by a hash of their spir-v, so the same code loaded through different paths
+// or loaded again unchanged creates a single module
+struct shader_module_cache
+{
+	VkDevice device = VK_NULL_HANDLE;
+	std::mutex mutex;
+	std::unordered_map<u64, VkShaderModule> modules;
+};
+
+void create_shader_module_cache(VkDevice device, shader_module_cache& cache);
+void destroy_shader_module_cache(shader_module_cache& cache);
+
+u64 hash_shader_code(const void* code, size_t size);
+
+// maps the file and hands the mapping straight to vkCreateShaderModule, returns VK_NULL_HANDLE on failure
+VkShaderModule load_shader_module(shader_module_cache& cache, const char* path);
+
+// destroys the module and forgets its code, pipelines already built from it stay valid. the handle may be
+// reused by a later module, so anything keyed on it has to be dropped as well
+void evict_shader_module(shader_module_cache& cache, VkShaderModule module);
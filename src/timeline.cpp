@@ -0,0 +1,97 @@
+#include "timeline.h"
+
+#include <iostream>
+#include <algorithm>
+
+bool create_queue_timeline(VkDevice device, queue_timeline& timeline)
+{
+	timeline.device = device;
+	timeline.submitted_value = 0;
+	timeline.completed_value = 0;
+
+	// the khr entry points share the core signatures, a 1.1 device only exposes those
+	timeline.get_semaphore_counter_value = (PFN_vkGetSemaphoreCounterValue)vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValue");
+	timeline.wait_semaphores = (PFN_vkWaitSemaphores)vkGetDeviceProcAddr(device, "vkWaitSemaphores");
+	if (!timeline.get_semaphore_counter_value || !timeline.wait_semaphores)
+	{
+		timeline.get_semaphore_counter_value = (PFN_vkGetSemaphoreCounterValue)vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR");
+		timeline.wait_semaphores = (PFN_vkWaitSemaphores)vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR");
+	}
+	if (!timeline.get_semaphore_counter_value || !timeline.wait_semaphores)
+	{
+		std::cout << "failed to load the timeline semaphore functions!" << std::endl;
+		return false;
+	}
+
+	VkSemaphoreTypeCreateInfo semaphore_type_specification{};
+	semaphore_type_specification.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	semaphore_type_specification.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	semaphore_type_specification.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphore_specification{};
+	semaphore_specification.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphore_specification.pNext = &semaphore_type_specification;
+
+	if (vkCreateSemaphore(device, &semaphore_specification, nullptr, &timeline.semaphore) != VK_SUCCESS)
+	{
+		std::cout << "failed to create timeline semaphore!" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void destroy_queue_timeline(queue_timeline& timeline)
+{
+	vkDestroySemaphore(timeline.device, timeline.semaphore, nullptr);
+	timeline.semaphore = VK_NULL_HANDLE;
+}
+
+u64 next_timeline_value(queue_timeline& timeline)
+{
+	return ++timeline.submitted_value;
+}
+
+u64 poll_timeline(queue_timeline& timeline)
+{
+	u64 value = 0;
+	if (timeline.get_semaphore_counter_value(timeline.device, timeline.semaphore, &value) == VK_SUCCESS)
+	{
+		timeline.completed_value = std::max(timeline.completed_value, value);
+	}
+	return timeline.completed_value;
+}
+
+bool timeline_reached(queue_timeline& timeline, u64 value)
+{
+	return value <= timeline.completed_value || value <= poll_timeline(timeline);
+}
+
+bool wait_for_timeline(queue_timeline& timeline, u64 value)
+{
+	timeline.wait_count++;
+	if (timeline_reached(timeline, value))
+	{
+		return true;
+	}
+
+	timeline.blocking_wait_count++;
+	VkSemaphoreWaitInfo wait_specification{};
+	wait_specification.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	wait_specification.semaphoreCount = 1;
+	wait_specification.pSemaphores = &timeline.semaphore;
+	wait_specification.pValues = &value;
+
+	if (timeline.wait_semaphores(timeline.device, &wait_specification, UINT64_MAX) != VK_SUCCESS)
+	{
+		std::cout << "failed to wait for timeline semaphore!" << std::endl;
+		return false;
+	}
+	timeline.completed_value = std::max(timeline.completed_value, value);
+	return true;
+}
+
+void print_queue_timeline_stats(const char* name, const queue_timeline& timeline)
+{
+	std::cout << name << " timeline: " << timeline.submitted_value << " submissions, " << timeline.wait_count << " waits, "
+		<< timeline.blocking_wait_count << " blocked" << std::endl;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "vulkancommon.h"
+
+// one timeline semaphore per queue. every submission to the queue signals the next value, so "has this work
+// finished" is a comparison against the last value seen completed and only falls back to asking the driver,
+// or blocking, when the cached value is too old. values are never reset, unlike fences
+struct queue_timeline
+{
+	VkDevice device = VK_NULL_HANDLE;
+	VkSemaphore semaphore = VK_NULL_HANDLE;
+	// the core 1.2 entry points, or the VK_KHR_timeline_semaphore ones on a 1.1 device
+	PFN_vkGetSemaphoreCounterValue get_semaphore_counter_value = nullptr;
+	PFN_vkWaitSemaphores wait_semaphores = nullptr;
+	// the value the latest submission signals
+	u64 submitted_value = 0;
+	// the highest value known to have been reached
+	u64 completed_value = 0;
+	u64 wait_count = 0;
+	u64 blocking_wait_count = 0;
+};
+
+bool create_queue_timeline(VkDevice device, queue_timeline& timeline);
+void destroy_queue_timeline(queue_timeline& timeline);
+
+// the value the next submission should signal, only call it for a submission that is actually made
+u64 next_timeline_value(queue_timeline& timeline);
+
+// refreshes completed_value from the driver without blocking
+u64 poll_timeline(queue_timeline& timeline);
+
+// true once the queue has passed value, never blocks
+bool timeline_reached(queue_timeline& timeline, u64 value);
+
+// blocks until the queue has passed value, returns immediately when it already has
+bool wait_for_timeline(queue_timeline& timeline, u64 value);
+
+void print_queue_timeline_stats(const char* name, const queue_timeline& timeline);
@@ -0,0 +1,58 @@
+#include "uploadarena.h"
+
+#include <iostream>
+#include <algorithm>
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+bool create_upload_arena(VkDevice device, device_memory_allocator& allocator, u32 region_count, VkDeviceSize region_size, VkDeviceSize alignment,
+	VkBufferUsageFlags usage, upload_arena& arena)
+{
+	arena.alignment = std::max(alignment, (VkDeviceSize)1);
+	arena.region_size = align_up(region_size, arena.alignment);
+	arena.region_count = region_count;
+	arena.current_region = 0;
+	arena.head = 0;
+	arena.high_water = 0;
+
+	// coherent memory needs no flushes, the wait for the frame before a reset already orders the gpu reads before new writes
+	if (!create_buffer(device, allocator, arena.region_size * region_count, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		{}, arena.buffer))
+	{
+		std::cout << "failed to create upload arena!" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void destroy_upload_arena(VkDevice device, device_memory_allocator& allocator, upload_arena& arena)
+{
+	destroy_buffer(device, allocator, arena.buffer);
+	arena.region_count = 0;
+}
+
+void reset_upload_arena(upload_arena& arena, u32 region)
+{
+	arena.current_region = region;
+	arena.head = 0;
+}
+
+bool arena_allocate(upload_arena& arena, VkDeviceSize size, arena_allocation& allocation)
+{
+	VkDeviceSize offset = align_up(arena.head, arena.alignment);
+	if (offset + size > arena.region_size)
+	{
+		std::cout << "upload arena region of " << arena.region_size << " bytes exhausted!" << std::endl;
+		return false;
+	}
+
+	arena.head = offset + size;
+	arena.high_water = std::max(arena.high_water, arena.head);
+
+	allocation.offset = arena.region_size * arena.current_region + offset;
+	allocation.data = (char*)arena.buffer.allocation.mapped + allocation.offset;
+	return true;
+}
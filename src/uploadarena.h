@@ -0,0 +1,37 @@
+#pragma once
+
+#include "vulkancommon.h"
+#include "gpubuffer.h"
+
+// transient per frame data (frame constants, per draw constants) is bump allocated out of one persistently mapped
+// buffer split into a region per frame in flight. a region is reset as a whole once the frame has retired on the gpu,
+// so the hot loop never creates buffers or maps memory. allocations are addressed through dynamic offsets
+struct upload_arena
+{
+	gpu_buffer buffer;
+	VkDeviceSize region_size = 0;
+	VkDeviceSize alignment = 1;
+	u32 region_count = 0;
+	u32 current_region = 0;
+	VkDeviceSize head = 0;
+	// the most any region has held, for sizing the arena
+	VkDeviceSize high_water = 0;
+};
+
+struct arena_allocation
+{
+	void* data = nullptr;
+	// from the start of the buffer, suitable as a dynamic offset
+	VkDeviceSize offset = 0;
+};
+
+// alignment must cover minUniformBufferOffsetAlignment and minStorageBufferOffsetAlignment for the usages given
+bool create_upload_arena(VkDevice device, device_memory_allocator& allocator, u32 region_count, VkDeviceSize region_size, VkDeviceSize alignment,
+	VkBufferUsageFlags usage, upload_arena& arena);
+void destroy_upload_arena(VkDevice device, device_memory_allocator& allocator, upload_arena& arena);
+
+// makes region the target of following allocations and drops everything allocated from it before
+void reset_upload_arena(upload_arena& arena, u32 region);
+
+// returns false when the region is full, the arena never grows so data already recorded stays where it is
+bool arena_allocate(upload_arena& arena, VkDeviceSize size, arena_allocation& allocation);
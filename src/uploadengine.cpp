@@ -0,0 +1,309 @@
+#include "uploadengine.h"
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+static bool create_command_pool(VkDevice device, u32 queue_family, VkCommandPool& command_pool)
+{
+	VkCommandPoolCreateInfo command_pool_specification{};
+	command_pool_specification.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_specification.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	command_pool_specification.queueFamilyIndex = queue_family;
+
+	if (vkCreateCommandPool(device, &command_pool_specification, nullptr, &command_pool) != VK_SUCCESS)
+	{
+		std::cout << "failed to create upload command pool!" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static VkCommandBuffer begin_one_time_commands(VkDevice device, VkCommandPool command_pool)
+{
+	VkCommandBufferAllocateInfo command_buffer_allocation_specification{};
+	command_buffer_allocation_specification.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	command_buffer_allocation_specification.commandPool = command_pool;
+	command_buffer_allocation_specification.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	command_buffer_allocation_specification.commandBufferCount = 1;
+
+	VkCommandBuffer command_buffer;
+	if (vkAllocateCommandBuffers(device, &command_buffer_allocation_specification, &command_buffer) != VK_SUCCESS)
+	{
+		std::cout << "failed to allocate upload command buffer!" << std::endl;
+		return VK_NULL_HANDLE;
+	}
+
+	VkCommandBufferBeginInfo command_buffer_begin_specification{};
+	command_buffer_begin_specification.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	command_buffer_begin_specification.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(command_buffer, &command_buffer_begin_specification);
+	return command_buffer;
+}
+
+bool create_upload_engine(VkDevice device, device_memory_allocator& allocator, VkQueue transfer_queue, u32 transfer_family, queue_timeline& transfer_timeline,
+	VkQueue graphics_queue, u32 graphics_family, queue_timeline& graphics_timeline, upload_engine& engine)
+{
+	engine.device = device;
+	engine.allocator = &allocator;
+	engine.transfer_queue = transfer_queue;
+	engine.transfer_family = transfer_family;
+	engine.transfer_timeline = &transfer_timeline;
+	engine.graphics_queue = graphics_queue;
+	engine.graphics_family = graphics_family;
+	engine.graphics_timeline = &graphics_timeline;
+
+	return create_command_pool(device, transfer_family, engine.transfer_command_pool) && create_command_pool(device, graphics_family, engine.graphics_command_pool);
+}
+
+static void free_batch(upload_engine& engine, upload_batch& batch)
+{
+	for (queued_upload& upload : batch.uploads)
+	{
+		destroy_buffer(engine.device, *engine.allocator, upload.staging_buffer);
+	}
+	if (batch.transfer_command_buffer != VK_NULL_HANDLE)
+	{
+		vkFreeCommandBuffers(engine.device, engine.transfer_command_pool, 1, &batch.transfer_command_buffer);
+	}
+	if (batch.acquire_command_buffer != VK_NULL_HANDLE)
+	{
+		vkFreeCommandBuffers(engine.device, engine.graphics_command_pool, 1, &batch.acquire_command_buffer);
+	}
+}
+
+void destroy_upload_engine(upload_engine& engine)
+{
+	for (upload_batch& batch : engine.batches)
+	{
+		free_batch(engine, batch);
+	}
+	for (queued_upload& upload : engine.queued)
+	{
+		destroy_buffer(engine.device, *engine.allocator, upload.staging_buffer);
+	}
+	engine.batches.clear();
+	engine.queued.clear();
+	vkDestroyCommandPool(engine.device, engine.transfer_command_pool, nullptr);
+	vkDestroyCommandPool(engine.device, engine.graphics_command_pool, nullptr);
+}
+
+bool queue_buffer_upload(upload_engine& engine, const void* data, VkDeviceSize size, VkBufferUsageFlags usage,
+	VkPipelineStageFlags destination_stages, VkAccessFlags destination_access, gpu_buffer& buffer)
+{
+	queued_upload upload;
+	if (!create_buffer(engine.device, *engine.allocator, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, {}, upload.staging_buffer))
+	{
+		return false;
+	}
+
+	std::memcpy(upload.staging_buffer.allocation.mapped, data, (size_t)size);
+
+	// exclusive to the graphics family, ownership moves over with each batch instead of every access paying for concurrent sharing
+	if (!create_buffer(engine.device, *engine.allocator, size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, {}, buffer))
+	{
+		destroy_buffer(engine.device, *engine.allocator, upload.staging_buffer);
+		return false;
+	}
+
+	upload.destination = buffer.buffer;
+	upload.size = size;
+	upload.destination_stages = destination_stages;
+	upload.destination_access = destination_access;
+	engine.queued.push_back(upload);
+	engine.queued_bytes += size;
+
+	if (engine.queued_bytes >= engine.max_queued_bytes)
+	{
+		return flush_uploads(engine);
+	}
+	return true;
+}
+
+bool flush_uploads(upload_engine& engine)
+{
+	if (engine.queued.empty())
+	{
+		return true;
+	}
+
+	upload_batch batch;
+	batch.uploads.swap(engine.queued);
+	engine.queued_bytes = 0;
+
+	batch.transfer_command_buffer = begin_one_time_commands(engine.device, engine.transfer_command_pool);
+	if (batch.transfer_command_buffer == VK_NULL_HANDLE)
+	{
+		free_batch(engine, batch);
+		return false;
+	}
+
+	bool ownership_transfer = engine.transfer_family != engine.graphics_family;
+	std::vector<VkBufferMemoryBarrier> release_barriers;
+	for (const queued_upload& upload : batch.uploads)
+	{
+		VkBufferCopy copy_region{};
+		copy_region.srcOffset = 0;
+		copy_region.dstOffset = 0;
+		copy_region.size = upload.size;
+		vkCmdCopyBuffer(batch.transfer_command_buffer, upload.staging_buffer.buffer, upload.destination, 1, &copy_region);
+
+		if (ownership_transfer)
+		{
+			VkBufferMemoryBarrier release_barrier{};
+			release_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			release_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			release_barrier.dstAccessMask = 0;
+			release_barrier.srcQueueFamilyIndex = engine.transfer_family;
+			release_barrier.dstQueueFamilyIndex = engine.graphics_family;
+			release_barrier.buffer = upload.destination;
+			release_barrier.offset = 0;
+			release_barrier.size = VK_WHOLE_SIZE;
+			release_barriers.push_back(release_barrier);
+		}
+		engine.uploaded_bytes += upload.size;
+	}
+
+	if (!release_barriers.empty())
+	{
+		vkCmdPipelineBarrier(batch.transfer_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+			0, nullptr, (u32)release_barriers.size(), release_barriers.data(), 0, nullptr);
+	}
+	vkEndCommandBuffer(batch.transfer_command_buffer);
+
+	batch.transfer_value = next_timeline_value(*engine.transfer_timeline);
+	VkTimelineSemaphoreSubmitInfo timeline_submit_specification{};
+	timeline_submit_specification.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timeline_submit_specification.signalSemaphoreValueCount = 1;
+	timeline_submit_specification.pSignalSemaphoreValues = &batch.transfer_value;
+
+	VkSubmitInfo submit_specification{};
+	submit_specification.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_specification.pNext = &timeline_submit_specification;
+	submit_specification.commandBufferCount = 1;
+	submit_specification.pCommandBuffers = &batch.transfer_command_buffer;
+	submit_specification.signalSemaphoreCount = 1;
+	submit_specification.pSignalSemaphores = &engine.transfer_timeline->semaphore;
+
+	if (vkQueueSubmit(engine.transfer_queue, 1, &submit_specification, VK_NULL_HANDLE) != VK_SUCCESS)
+	{
+		// the value was never signalled, hand it back so later waits do not hang on it
+		engine.transfer_timeline->submitted_value--;
+		std::cout << "failed to submit upload batch!" << std::endl;
+		free_batch(engine, batch);
+		return false;
+	}
+
+	engine.upload_count += batch.uploads.size();
+	engine.batch_count++;
+	engine.batches.push_back(std::move(batch));
+	return true;
+}
+
+bool submit_upload_acquires(upload_engine& engine)
+{
+	std::vector<VkBufferMemoryBarrier> acquire_barriers;
+	VkPipelineStageFlags acquire_stages = 0;
+	u64 wait_value = 0;
+	bool ownership_transfer = engine.transfer_family != engine.graphics_family;
+
+	for (upload_batch& batch : engine.batches)
+	{
+		if (batch.acquired)
+		{
+			continue;
+		}
+		for (const queued_upload& upload : batch.uploads)
+		{
+			VkBufferMemoryBarrier acquire_barrier{};
+			acquire_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			acquire_barrier.srcAccessMask = ownership_transfer ? 0 : VK_ACCESS_TRANSFER_WRITE_BIT;
+			acquire_barrier.dstAccessMask = upload.destination_access;
+			acquire_barrier.srcQueueFamilyIndex = ownership_transfer ? engine.transfer_family : VK_QUEUE_FAMILY_IGNORED;
+			acquire_barrier.dstQueueFamilyIndex = ownership_transfer ? engine.graphics_family : VK_QUEUE_FAMILY_IGNORED;
+			acquire_barrier.buffer = upload.destination;
+			acquire_barrier.offset = 0;
+			acquire_barrier.size = VK_WHOLE_SIZE;
+			acquire_barriers.push_back(acquire_barrier);
+			acquire_stages |= upload.destination_stages;
+		}
+		wait_value = std::max(wait_value, batch.transfer_value);
+	}
+
+	if (acquire_barriers.empty())
+	{
+		return true;
+	}
+
+	VkCommandBuffer command_buffer = begin_one_time_commands(engine.device, engine.graphics_command_pool);
+	if (command_buffer == VK_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	// across queues the semaphore wait already orders the copies, the acquire only chains onto the wait stages.
+	// on one queue there is no semaphore and the barrier has to wait for the copies itself
+	VkPipelineStageFlags source_stages = ownership_transfer ? acquire_stages : VK_PIPELINE_STAGE_TRANSFER_BIT;
+	vkCmdPipelineBarrier(command_buffer, source_stages, acquire_stages, 0, 0, nullptr, (u32)acquire_barriers.size(), acquire_barriers.data(), 0, nullptr);
+	vkEndCommandBuffer(command_buffer);
+
+	u64 acquire_value = next_timeline_value(*engine.graphics_timeline);
+	u64 wait_values[] = { wait_value };
+	VkTimelineSemaphoreSubmitInfo timeline_submit_specification{};
+	timeline_submit_specification.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timeline_submit_specification.waitSemaphoreValueCount = ownership_transfer ? 1 : 0;
+	timeline_submit_specification.pWaitSemaphoreValues = wait_values;
+	timeline_submit_specification.signalSemaphoreValueCount = 1;
+	timeline_submit_specification.pSignalSemaphoreValues = &acquire_value;
+
+	VkSubmitInfo submit_specification{};
+	submit_specification.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_specification.pNext = &timeline_submit_specification;
+	submit_specification.waitSemaphoreCount = ownership_transfer ? 1 : 0;
+	submit_specification.pWaitSemaphores = &engine.transfer_timeline->semaphore;
+	submit_specification.pWaitDstStageMask = &acquire_stages;
+	submit_specification.commandBufferCount = 1;
+	submit_specification.pCommandBuffers = &command_buffer;
+	submit_specification.signalSemaphoreCount = 1;
+	submit_specification.pSignalSemaphores = &engine.graphics_timeline->semaphore;
+
+	if (vkQueueSubmit(engine.graphics_queue, 1, &submit_specification, VK_NULL_HANDLE) != VK_SUCCESS)
+	{
+		engine.graphics_timeline->submitted_value--;
+		std::cout << "failed to submit upload acquire!" << std::endl;
+		vkFreeCommandBuffers(engine.device, engine.graphics_command_pool, 1, &command_buffer);
+		return false;
+	}
+
+	// the command buffer is owned by the newest batch, which is the last of them to finish on the transfer queue
+	for (upload_batch& batch : engine.batches)
+	{
+		if (!batch.acquired)
+		{
+			batch.acquired = true;
+			batch.acquire_value = acquire_value;
+		}
+	}
+	engine.batches.back().acquire_command_buffer = command_buffer;
+	return true;
+}
+
+void collect_finished_uploads(upload_engine& engine)
+{
+	for (auto it = engine.batches.begin(); it != engine.batches.end();)
+	{
+		if (!it->acquired || !timeline_reached(*engine.transfer_timeline, it->transfer_value) || !timeline_reached(*engine.graphics_timeline, it->acquire_value))
+		{
+			it++;
+			continue;
+		}
+		free_batch(engine, *it);
+		it = engine.batches.erase(it);
+	}
+}
+
+void print_upload_engine_stats(const upload_engine& engine)
+{
+	std::cout << "upload engine: " << engine.upload_count << " uploads, " << engine.uploaded_bytes << " bytes in " << engine.batch_count << " batches" << std::endl;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "vulkancommon.h"
+#include "gpubuffer.h"
+#include "timeline.h"
+
+#include <vector>
+
+// copies into device local buffers run on the transfer queue without the cpu waiting for them. queued copies
+// are recorded into one command buffer per flush, and the batch signals the transfer timeline. buffers are
+// exclusive to the graphics family: on a dedicated transfer family every batch releases its buffers, and a small
+// graphics submission that waits for the batch's timeline value acquires them. without a dedicated family the
+// acquire submission only makes the copies visible. a destination may be recorded into command buffers right
+// away but must not execute before submit_upload_acquires has been called for its batch
+struct queued_upload
+{
+	gpu_buffer staging_buffer;
+	VkBuffer destination = VK_NULL_HANDLE;
+	VkDeviceSize size = 0;
+	VkPipelineStageFlags destination_stages = 0;
+	VkAccessFlags destination_access = 0;
+};
+
+struct upload_batch
+{
+	u64 transfer_value = 0;
+	VkCommandBuffer transfer_command_buffer = VK_NULL_HANDLE;
+	std::vector<queued_upload> uploads;
+	bool acquired = false;
+	u64 acquire_value = 0;
+	VkCommandBuffer acquire_command_buffer = VK_NULL_HANDLE;
+};
+
+struct upload_engine
+{
+	VkDevice device = VK_NULL_HANDLE;
+	device_memory_allocator* allocator = nullptr;
+	VkQueue transfer_queue = VK_NULL_HANDLE;
+	VkQueue graphics_queue = VK_NULL_HANDLE;
+	u32 transfer_family = nullval;
+	u32 graphics_family = nullval;
+	queue_timeline* transfer_timeline = nullptr;
+	queue_timeline* graphics_timeline = nullptr;
+	VkCommandPool transfer_command_pool = VK_NULL_HANDLE;
+	VkCommandPool graphics_command_pool = VK_NULL_HANDLE;
+	// queued copies are flushed on their own once their staging memory passes this
+	VkDeviceSize max_queued_bytes = 64ull * 1024 * 1024;
+
+	std::vector<queued_upload> queued;
+	VkDeviceSize queued_bytes = 0;
+	std::vector<upload_batch> batches;
+
+	u64 upload_count = 0;
+	u64 batch_count = 0;
+	VkDeviceSize uploaded_bytes = 0;
+};
+
+// transfer_queue may be the graphics queue, both timelines are then the same one
+bool create_upload_engine(VkDevice device, device_memory_allocator& allocator, VkQueue transfer_queue, u32 transfer_family, queue_timeline& transfer_timeline,
+	VkQueue graphics_queue, u32 graphics_family, queue_timeline& graphics_timeline, upload_engine& engine);
+// the device must be idle
+void destroy_upload_engine(upload_engine& engine);
+
+// creates buffer with usage | TRANSFER_DST and queues a copy of data into it. destination_stages and
+// destination_access describe the first use on the graphics queue
+bool queue_buffer_upload(upload_engine& engine, const void* data, VkDeviceSize size, VkBufferUsageFlags usage,
+	VkPipelineStageFlags destination_stages, VkAccessFlags destination_access, gpu_buffer& buffer);
+
+// submits every queued copy as one batch, does nothing when nothing is queued
+bool flush_uploads(upload_engine& engine);
+
+// makes every flushed batch usable by graphics submissions made after this call
+bool submit_upload_acquires(upload_engine& engine);
+
+// frees the staging memory and command buffers of batches both queues are done with, never blocks
+void collect_finished_uploads(upload_engine& engine);
+
+void print_upload_engine_stats(const upload_engine& engine);
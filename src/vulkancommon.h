@@ -0,0 +1,9 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <stdint.h>
+
+typedef uint32_t u32;
+typedef uint64_t u64;
+constexpr u32 nullval = 4294967295;
@@ -0,0 +1,69 @@
+#include "workerpool.h"
+
+static void worker_main(worker_pool& pool, u32 worker_index)
+{
+	u64 seen_generation = 0;
+	while (true)
+	{
+		std::function<void(u32)> job;
+		{
+			std::unique_lock<std::mutex> lock(pool.mutex);
+			pool.job_ready.wait(lock, [&]() { return pool.stopping || pool.job_generation != seen_generation; });
+			if (pool.stopping)
+			{
+				return;
+			}
+			seen_generation = pool.job_generation;
+			job = pool.job;
+		}
+
+		job(worker_index);
+
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		if (--pool.workers_remaining == 0)
+		{
+			pool.job_done.notify_one();
+		}
+	}
+}
+
+void start_worker_pool(worker_pool& pool, u32 worker_count)
+{
+	pool.stopping = false;
+	for (u32 i = 0; i < worker_count; i++)
+	{
+		pool.threads.emplace_back(worker_main, std::ref(pool), i);
+	}
+}
+
+void run_on_workers(worker_pool& pool, const std::function<void(u32)>& job)
+{
+	if (pool.threads.empty())
+	{
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(pool.mutex);
+	pool.job = job;
+	pool.workers_remaining = (u32)pool.threads.size();
+	pool.job_generation++;
+	pool.job_ready.notify_all();
+
+	pool.job_done.wait(lock, [&]() { return pool.workers_remaining == 0; });
+	pool.job = nullptr;
+}
+
+void stop_worker_pool(worker_pool& pool)
+{
+	{
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		pool.stopping = true;
+	}
+	pool.job_ready.notify_all();
+
+	for (auto& thread : pool.threads)
+	{
+		thread.join();
+	}
+	pool.threads.clear();
+}
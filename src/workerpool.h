@@ -0,0 +1,27 @@
+#pragma once
+
+#include "vulkancommon.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fork/join pool: run_on_workers hands the same job to every worker and returns once all of them are done,
+// the job receives the index of the worker running it
+struct worker_pool
+{
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable job_ready;
+	std::condition_variable job_done;
+	std::function<void(u32)> job;
+	u64 job_generation = 0;
+	u32 workers_remaining = 0;
+	bool stopping = false;
+};
+
+void start_worker_pool(worker_pool& pool, u32 worker_count);
+void run_on_workers(worker_pool& pool, const std::function<void(u32)>& job);
+void stop_worker_pool(worker_pool& pool);